@@ -1,5 +1,13 @@
+#include <algorithm>
+#include <array>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
+#include <initializer_list>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <valarray>
 #include <vector>
 
 const double phi = (1.0 + std::sqrt(5.0)) / 2.0;
@@ -12,6 +20,7 @@ size_t fibonacciRec(size_t n, std::vector<size_t>& cache) {
 }
 
 size_t fibonacci(size_t n) {
+    if (n == 0) return 0;
     if (n <= 2) return 1;
     std::vector<size_t> cache(n);
     cache[0] = 1;
@@ -21,12 +30,253 @@ size_t fibonacci(size_t n) {
 
 size_t fibonacci2(size_t n) {
     double phi_n = std::pow(phi, n);
-    return static_cast<size_t>(phi_n / std::sqrt(5.0));
+    return static_cast<size_t>(std::round(phi_n / std::sqrt(5.0)));
 }
 
+// Unsigned integer of unbounded size, just enough to run the recurrences
+// below without overflow.
+struct BigUnsigned {
+    std::vector<uint32_t> limbs;
+
+    BigUnsigned(uint64_t value = 0) {
+        while (value) {
+            limbs.push_back(static_cast<uint32_t>(value));
+            value >>= 32u;
+        }
+    }
+
+    BigUnsigned& operator+=(const BigUnsigned& rhs) {
+        limbs.resize(std::max(limbs.size(), rhs.limbs.size()));
+        uint64_t carry = 0;
+        for (size_t i = 0; i < limbs.size(); i++) {
+            carry += limbs[i];
+            if (i < rhs.limbs.size()) {
+                carry += rhs.limbs[i];
+            }
+            limbs[i] = static_cast<uint32_t>(carry);
+            carry >>= 32u;
+        }
+        if (carry) {
+            limbs.push_back(static_cast<uint32_t>(carry));
+        }
+        return *this;
+    }
+
+    friend BigUnsigned operator+(BigUnsigned lhs, const BigUnsigned& rhs) {
+        lhs += rhs;
+        return lhs;
+    }
+
+    friend BigUnsigned operator*(const BigUnsigned& lhs, const BigUnsigned& rhs) {
+        BigUnsigned res;
+        if (lhs.limbs.empty() || rhs.limbs.empty()) {
+            return res;
+        }
+        res.limbs.resize(lhs.limbs.size() + rhs.limbs.size());
+        for (size_t i = 0; i < lhs.limbs.size(); i++) {
+            uint64_t carry = 0;
+            for (size_t j = 0; j < rhs.limbs.size(); j++) {
+                carry += static_cast<uint64_t>(lhs.limbs[i]) * rhs.limbs[j] + res.limbs[i + j];
+                res.limbs[i + j] = static_cast<uint32_t>(carry);
+                carry >>= 32u;
+            }
+            res.limbs[i + rhs.limbs.size()] = static_cast<uint32_t>(carry);
+        }
+        while (!res.limbs.empty() && res.limbs.back() == 0) {
+            res.limbs.pop_back();
+        }
+        return res;
+    }
+
+    bool operator==(const BigUnsigned&) const = default;
+
+    std::string toString() const {
+        if (limbs.empty()) {
+            return "0";
+        }
+        std::vector<uint32_t> digits = limbs;
+        std::string res;
+        while (!digits.empty()) {
+            uint64_t rem = 0;
+            for (size_t i = digits.size() - 1; i < digits.size(); i--) {
+                uint64_t cur = (rem << 32u) | digits[i];
+                digits[i] = static_cast<uint32_t>(cur / 1'000'000'000);
+                rem = cur % 1'000'000'000;
+            }
+            while (!digits.empty() && digits.back() == 0) {
+                digits.pop_back();
+            }
+            for (size_t i = 0; i < 9 && (!digits.empty() || rem); i++) {
+                res.push_back(static_cast<char>('0' + rem % 10));
+                rem /= 10;
+            }
+        }
+        std::reverse(res.begin(), res.end());
+        return res;
+    }
+};
+
+std::ostream& operator<<(std::ostream& os, const BigUnsigned& n) {
+    return os << n.toString();
+}
+
+template <typename T>
+concept Arithmetic = std::is_arithmetic_v<T> || std::is_same_v<T, BigUnsigned>;
+
+template <Arithmetic T, size_t R, size_t C>
+struct Matrix {
+    std::valarray<T> data;
+    Matrix() : data(R * C) {}
+    Matrix(std::initializer_list<T> il) : data(il) {
+        assert(il.size() == R * C);
+    }
+
+    auto begin() { return std::begin(data);}
+    auto begin() const { return std::begin(data);}
+    auto end() { return std::end(data);}
+    auto end() const { return std::end(data);}
+
+    T& operator()(size_t r, size_t c) {return data[r * C + c];}
+    const T& operator()(size_t r, size_t c) const {return data[r * C + c];}
+};
+
+template <Arithmetic T1, Arithmetic T2, size_t M, size_t K, size_t N, Arithmetic T3 = std::common_type_t<T1, T2>>
+Matrix<T3, M, N> operator*(const Matrix<T1, M, K>& m1, const Matrix<T2, K, N>& m2) {
+    Matrix<T3, M, N> m3;
+    for (size_t m = 0; m < M; m++) {
+        for (size_t n = 0; n < N; n++) {
+            for (size_t k = 0; k < K; k++) {
+                m3(m, n) += m1(m, k) * m2(k, n);
+            }
+        }
+    }
+    return m3;
+}
+
+// a_n = coeffs[0] * a_{n-1} + ... + coeffs[K-1] * a_{n-K} with a_0, ..., a_{K-1} = initial.
+// The state (a_{n+K-1}, ..., a_n) advances by one step when multiplied by the
+// companion matrix, so a_n comes from its n-th power, computed by repeated
+// squaring. A nonzero modulus reduces every product; it needs an unsigned T
+// of at most 64 bits.
+template <Arithmetic T, size_t K>
+struct LinearRecurrence {
+    Matrix<T, K, K> companion;
+    Matrix<T, K, 1> initial_state;
+    T modulus;
+
+    LinearRecurrence(const std::array<T, K>& coeffs, const std::array<T, K>& initial, T modulus = T{})
+            : modulus {modulus} {
+        for (size_t k = 0; k < K; k++) {
+            companion(0, k) = reduce(coeffs[k]);
+            if (k + 1 < K) {
+                companion(k + 1, k) = T{1};
+            }
+            initial_state(K - 1 - k, 0) = reduce(initial[k]);
+        }
+    }
+
+    T reduce(const T& value) const {
+        if constexpr (std::is_integral_v<T>) {
+            if (modulus) {
+                return value % modulus;
+            }
+        }
+        return value;
+    }
+
+    template <size_t N>
+    Matrix<T, K, N> multiply(const Matrix<T, K, K>& lhs, const Matrix<T, K, N>& rhs) const {
+        if constexpr (std::is_integral_v<T>) {
+            static_assert(sizeof(T) <= sizeof(uint64_t));
+            if (modulus) {
+                Matrix<T, K, N> res;
+                for (size_t m = 0; m < K; m++) {
+                    for (size_t n = 0; n < N; n++) {
+                        unsigned __int128 sum = 0;
+                        for (size_t k = 0; k < K; k++) {
+                            sum += static_cast<unsigned __int128>(lhs(m, k)) * rhs(k, n) % modulus;
+                        }
+                        res(m, n) = static_cast<T>(sum % modulus);
+                    }
+                }
+                return res;
+            }
+        }
+        return lhs * rhs;
+    }
+
+    T operator()(uint64_t n) const {
+        Matrix<T, K, 1> state = initial_state;
+        Matrix<T, K, K> power = companion;
+        for (; n; n >>= 1u) {
+            if (n & 1u) {
+                state = multiply(power, state);
+            }
+            if (n > 1) {
+                power = multiply(power, power);
+            }
+        }
+        return state(K - 1, 0);
+    }
+
+    // Squares the companion matrix once for all queries and then spends only
+    // matrix-vector products, O(K^2 log n), on each one.
+    std::vector<T> evaluate(const std::vector<uint64_t>& ns) const {
+        uint64_t max_n = ns.empty() ? 0 : *std::max_element(ns.begin(), ns.end());
+        std::vector<Matrix<T, K, K>> powers {companion};
+        for (max_n >>= 1u; max_n; max_n >>= 1u) {
+            powers.push_back(multiply(powers.back(), powers.back()));
+        }
+        std::vector<T> res;
+        res.reserve(ns.size());
+        for (auto n : ns) {
+            Matrix<T, K, 1> state = initial_state;
+            for (size_t bit = 0; n; n >>= 1u, bit++) {
+                if (n & 1u) {
+                    state = multiply(powers[bit], state);
+                }
+            }
+            res.push_back(state(K - 1, 0));
+        }
+        return res;
+    }
+};
+
 int main() {
     for (size_t i = 0; i < 30; i++) {
         assert(fibonacci(i) == fibonacci2(i));
     }
 
+    LinearRecurrence<uint64_t, 2> fib({1, 1}, {0, 1});
+    uint64_t a = 0, b = 1;
+    for (size_t i = 0; i < 94; i++) {
+        assert(fib(i) == a);
+        b += a;
+        a = b - a;
+    }
+
+    constexpr uint64_t MOD = 1'000'000'007;
+    LinearRecurrence<uint64_t, 2> fib_mod({1, 1}, {0, 1}, MOD);
+    for (size_t i = 0; i < 94; i++) {
+        assert(fib_mod(i) == fib(i) % MOD);
+    }
+    std::vector<uint64_t> ns {1'000'000'000'000'000'000, 123'456'789, 0, 1'000'000'000'000'000'001, 2'000'000'000'000'000'000};
+    auto values = fib_mod.evaluate(ns);
+    for (size_t i = 0; i < ns.size(); i++) {
+        assert(values[i] == fib_mod(ns[i]));
+    }
+    assert((values[0] + values[3]) % MOD == fib_mod(ns[3] + 1));
+    // F(2n) = F(n) * (F(n) + 2 F(n - 1))
+    assert(values[4] == values[0] * ((values[0] + 2 * fib_mod(ns[0] - 1)) % MOD) % MOD);
+
+    LinearRecurrence<BigUnsigned, 2> fib_big({1, 1}, {0, 1});
+    assert(fib_big(100).toString() == "354224848179261915075");
+    auto big_values = fib_big.evaluate({500, 501, 502});
+    assert(big_values[0] + big_values[1] == big_values[2]);
+
+    LinearRecurrence<BigUnsigned, 3> tribonacci({1, 1, 1}, {0, 0, 1});
+    std::cout << "F(1000) = " << fib_big(1000) << '\n';
+    std::cout << "T(1000) = " << tribonacci(1000) << '\n';
+    std::cout << "F(10^18) mod 1e9+7 = " << values[0] << '\n';
+
 }
\ No newline at end of file
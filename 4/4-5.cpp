@@ -1,59 +1,172 @@
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
+#include <iostream>
 #include <random>
+#include <thread>
 #include <utility>
 #include <vector>
 
-std::mt19937 gen(std::random_device{}());
-std::bernoulli_distribution d(0.5);
+// Splits [0, n) into num_threads contiguous chunks and runs f(low, high, t) on each.
+template <typename F>
+void parallelFor(size_t n, size_t num_threads, F f) {
+    num_threads = std::clamp<size_t>(num_threads, 1, std::max<size_t>(n, 1));
+    if (num_threads == 1) {
+        f(0, n, 0);
+        return;
+    }
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < num_threads; t++) {
+        workers.emplace_back(f, n * t / num_threads, n * (t + 1) / num_threads, t);
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+}
 
-std::vector<int> chips;
+struct ChipTestResult {
+    std::vector<int> predictions;
+    size_t good_chip;
+    size_t tests;
+};
 
-std::pair<bool, bool> report(size_t A, size_t B) {
-    std::pair<bool, bool> res = {false, false};
-    if (chips[A]) {
-        res.first = chips[B];
-    } else {
-        res.first = d(gen);
+// report(A, B) returns what A says about B and what B says about A. It is
+// called concurrently, so it has to be thread-safe, and is taken by
+// reference so a tester holding a whole lot is not copied. More than half
+// of the chips must be good.
+template <typename Tester>
+ChipTestResult testChips(size_t num_chips, const Tester& report, size_t num_threads = std::thread::hardware_concurrency()) {
+    assert(num_chips > 0);
+    num_threads = std::max<size_t>(num_threads, 1);
+    std::vector<size_t> candidates(num_chips);
+    for (size_t i = 0; i < num_chips; i++) {
+        candidates[i] = i;
+    }
+    std::vector<std::vector<size_t>> kept(num_threads);
+    std::vector<size_t> tests(num_threads);
+    while (candidates.size() > 1) {
+        size_t pairs = candidates.size() / 2;
+        for (auto& k : kept) {
+            k.clear();
+        }
+        parallelFor(pairs, num_threads, [&](size_t low, size_t high, size_t t) {
+            for (size_t p = low; p < high; p++) {
+                auto [resA, resB] = report(candidates[2 * p], candidates[2 * p + 1]);
+                tests[t]++;
+                if (resA && resB) { // both say good: both good or both bad, keep one.
+                    kept[t].push_back(candidates[2 * p]);
+                }
+            }
+        });
+        size_t leftover = candidates.back();
+        bool odd = candidates.size() % 2 == 1;
+        candidates.clear();
+        for (const auto& k : kept) {
+            candidates.insert(candidates.end(), k.begin(), k.end());
+        }
+        // The unpaired chip only keeps the good majority if the kept count is even.
+        if (odd && candidates.size() % 2 == 0) {
+            candidates.push_back(leftover);
+        }
+        assert(!candidates.empty());
     }
-    if (chips[B]) {
-        res.second = chips[A];
-    } else {
-        res.second = d(gen);
+
+    ChipTestResult res {std::vector<int>(num_chips), candidates[0], 0};
+    res.predictions[res.good_chip] = 1;
+    parallelFor(num_chips, num_threads, [&](size_t low, size_t high, size_t t) {
+        for (size_t i = low; i < high; i++) {
+            if (i != res.good_chip) {
+                res.predictions[i] = report(res.good_chip, i).first;
+                tests[t]++;
+            }
+        }
+    });
+    for (auto n : tests) {
+        res.tests += n;
     }
     return res;
 }
 
+// Runs many independent lots at once, one lot per thread at a time.
+// report(lot, A, B) tests chips A and B of the given lot.
+template <typename Tester>
+std::vector<ChipTestResult> testChipLots(const std::vector<size_t>& lot_sizes, const Tester& report,
+                                         size_t num_threads = std::thread::hardware_concurrency()) {
+    std::vector<ChipTestResult> res(lot_sizes.size());
+    std::atomic<size_t> next_lot {0};
+    parallelFor(num_threads, num_threads, [&](size_t, size_t, size_t) {
+        for (size_t lot = next_lot++; lot < lot_sizes.size(); lot = next_lot++) {
+            res[lot] = testChips(lot_sizes[lot], [&report, lot](size_t A, size_t B) {
+                return report(lot, A, B);
+            }, 1);
+        }
+    });
+    return res;
+}
 
-int main() {
-    constexpr size_t NUM_CHIPS = 30;
-    chips.resize(NUM_CHIPS);
-    for (size_t i = 0; i < 1 + NUM_CHIPS / 2; i++) {
-        chips[i] = 1;
-    }
-    std::shuffle(chips.begin(), chips.end(), gen);
-    std::vector<int> predictions(chips.size());
-    for (size_t i = 0; i < NUM_CHIPS - 1; i++) {
-        auto [resA, resB] = report(i, i + 1);
-        if (resA && resB) { // report say that both is good.
-            predictions[i] = 1; // take the first, discard the second
-        } else {
-            i++; // discard both of them
+// Good chips tell the truth, bad chips answer at random.
+struct SimulatedLot {
+    std::vector<int> chips;
+
+    SimulatedLot(size_t num_chips, std::mt19937& gen) : chips(num_chips) {
+        for (size_t i = 0; i < 1 + num_chips / 2; i++) {
+            chips[i] = 1;
         }
+        std::shuffle(chips.begin(), chips.end(), gen);
     }
-    size_t last_good = 0;
-    for (size_t i = NUM_CHIPS - 1; i < NUM_CHIPS; i--) {
-        if (predictions[i]) {
-            last_good = i;
-            break;
+
+    std::pair<bool, bool> operator()(size_t A, size_t B) const {
+        static thread_local std::mt19937 gen(std::random_device{}());
+        std::pair<bool, bool> res = {false, false};
+        if (chips[A]) {
+            res.first = chips[B];
+        } else {
+            res.first = gen() & 1u;
         }
-    }
-    for (size_t i = 0; i < NUM_CHIPS; i++) {
-        if (i == last_good) {
-            continue;
+        if (chips[B]) {
+            res.second = chips[A];
+        } else {
+            res.second = gen() & 1u;
         }
-        bool resI = report(last_good, i).first;
-        predictions[i] = resI;
+        return res;
+    }
+};
+
+int main() {
+    std::mt19937 gen(std::random_device{}());
+
+    for (size_t num_chips = 1; num_chips <= 30; num_chips++) {
+        SimulatedLot lot(num_chips, gen);
+        auto res = testChips(num_chips, lot, 1 + num_chips % 4);
+        assert(res.predictions == lot.chips);
+        assert(res.tests < 2 * num_chips);
+    }
+
+    constexpr size_t NUM_CHIPS = 10'000'000;
+    SimulatedLot lot(NUM_CHIPS, gen);
+    auto t1 = std::chrono::steady_clock::now();
+    auto res = testChips(NUM_CHIPS, lot);
+    auto t2 = std::chrono::steady_clock::now();
+    assert(res.predictions == lot.chips);
+    std::cout << "Tested " << NUM_CHIPS << " chips with " << res.tests << " tests in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count() << "ms\n";
+
+    constexpr size_t NUM_LOTS = 1000;
+    std::vector<size_t> lot_sizes(NUM_LOTS);
+    std::vector<SimulatedLot> lots;
+    for (size_t l = 0; l < NUM_LOTS; l++) {
+        lot_sizes[l] = 1 + l % 997;
+        lots.emplace_back(lot_sizes[l], gen);
+    }
+    auto results = testChipLots(lot_sizes, [&lots](size_t l, size_t A, size_t B) {
+        return lots[l](A, B);
+    });
+    size_t total_tests = 0;
+    for (size_t l = 0; l < NUM_LOTS; l++) {
+        assert(results[l].predictions == lots[l].chips);
+        total_tests += results[l].tests;
     }
-    assert(predictions == chips);
+    std::cout << "Tested " << NUM_LOTS << " lots with " << total_tests << " tests\n";
 
 }
\ No newline at end of file
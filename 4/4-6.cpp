@@ -1,7 +1,11 @@
 #include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
 #include <iostream>
 #include <iterator>
+#include <random>
 #include <vector>
 
 std::vector<size_t> get_argmax(const std::vector<std::vector<int>>& monge) {
@@ -39,6 +43,71 @@ std::vector<size_t> get_argmax(const std::vector<std::vector<int>>& monge) {
     return res;
 }
 
+// SMAWK over an implicit totally monotone matrix: cost(i, j) is only
+// evaluated on demand and each level passes row and column indices down
+// instead of copying rows, so m rows and n columns take O(m + n) calls.
+template <typename Cost>
+void smawkRec(const std::vector<size_t>& rows, const std::vector<size_t>& cols, Cost& cost, std::vector<size_t>& res) {
+    if (rows.empty()) {
+        return;
+    }
+    std::vector<size_t> reduced;
+    reduced.reserve(rows.size());
+    for (auto c : cols) {
+        while (!reduced.empty() && cost(rows[reduced.size() - 1], reduced.back()) > cost(rows[reduced.size() - 1], c)) {
+            reduced.pop_back();
+        }
+        if (reduced.size() < rows.size()) {
+            reduced.push_back(c);
+        }
+    }
+    std::vector<size_t> odd_rows;
+    odd_rows.reserve(rows.size() / 2);
+    for (size_t r = 1; r < rows.size(); r += 2) {
+        odd_rows.push_back(rows[r]);
+    }
+    smawkRec(odd_rows, reduced, cost, res);
+    size_t j = 0;
+    for (size_t r = 0; r < rows.size(); r += 2) {
+        size_t last = (r + 1 < rows.size()) ? res[rows[r + 1]] : reduced.back();
+        size_t best = reduced[j];
+        auto best_cost = cost(rows[r], best);
+        while (reduced[j] != last) {
+            j++;
+            auto cur_cost = cost(rows[r], reduced[j]);
+            if (cur_cost < best_cost) {
+                best_cost = cur_cost;
+                best = reduced[j];
+            }
+        }
+        res[rows[r]] = best;
+    }
+}
+
+template <typename Cost>
+std::vector<size_t> smawk(size_t m, size_t n, Cost cost) {
+    std::vector<size_t> res(m);
+    if (m == 0 || n == 0) {
+        return res;
+    }
+    std::vector<size_t> rows(m), cols(n);
+    for (size_t i = 0; i < m; i++) {
+        rows[i] = i;
+    }
+    for (size_t j = 0; j < n; j++) {
+        cols[j] = j;
+    }
+    smawkRec(rows, cols, cost, res);
+    return res;
+}
+
+std::vector<size_t> smawk(const std::vector<std::vector<int>>& monge) {
+    if (monge.empty()) {
+        return {};
+    }
+    return smawk(monge.size(), monge[0].size(), [&monge](size_t i, size_t j) { return monge[i][j]; });
+}
+
 int main() {
     std::vector<std::vector<int>> monge {{10, 17, 13, 28, 23},
                                          {17, 22, 16, 29, 23},
@@ -52,5 +121,57 @@ int main() {
     for (auto n : argmaxes) {
         std::cout << n << '\n';
     }
+    assert(smawk(monge) == argmaxes);
+
+    std::mt19937 gen(std::random_device{}());
+    std::uniform_int_distribution<> weight(0, 3);
+    std::uniform_int_distribution<> offset(-20, 20);
+    for (size_t t = 0; t < 1000; t++) {
+        size_t m = 1 + t % 17, n = 1 + t % 13;
+        std::vector<std::vector<int>> random_monge(m, std::vector<int>(n));
+        std::vector<int> col_offset(n);
+        for (auto& c : col_offset) {
+            c = offset(gen);
+        }
+        std::vector<int> above(n);
+        for (size_t i = 0; i < m; i++) {
+            int row_offset = offset(gen);
+            int prefix = 0;
+            for (size_t j = 0; j < n; j++) {
+                prefix += weight(gen);
+                above[j] += prefix;
+                random_monge[i][j] = row_offset + col_offset[j] - above[j];
+            }
+        }
+        auto minima = smawk(random_monge);
+        for (size_t i = 0; i < m; i++) {
+            auto& row = random_monge[i];
+            assert(minima[i] == static_cast<size_t>(std::distance(row.begin(), std::min_element(row.begin(), row.end()))));
+        }
+    }
+
+    constexpr size_t N = 1'000'000;
+    std::uniform_int_distribution<int64_t> point(0, 1'000'000'000);
+    std::vector<int64_t> x(N), y(N);
+    for (size_t i = 0; i < N; i++) {
+        x[i] = point(gen);
+        y[i] = point(gen);
+    }
+    std::sort(x.begin(), x.end());
+    std::sort(y.begin(), y.end());
+    size_t evaluations = 0;
+    auto t1 = std::chrono::steady_clock::now();
+    auto minima = smawk(N, N, [&](size_t i, size_t j) {
+        evaluations++;
+        return (x[i] - y[j]) * (x[i] - y[j]);
+    });
+    auto t2 = std::chrono::steady_clock::now();
+    std::cout << "SMAWK on implicit " << N << "x" << N << " matrix: " << evaluations << " cost evaluations, "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count() << "ms\n";
+    for (size_t i = 0; i < N; i += N / 10) {
+        size_t j = minima[i];
+        assert(j == 0 || std::abs(x[i] - y[j - 1]) > std::abs(x[i] - y[j]));
+        assert(j + 1 == N || std::abs(x[i] - y[j + 1]) >= std::abs(x[i] - y[j]));
+    }
 
 }
\ No newline at end of file
@@ -1,15 +1,21 @@
+#include <algorithm>
+#include <cassert>
 #include <chrono>
+#include <cstdint>
 #include <iostream>
 #include <limits>
+#include <numeric>
+#include <thread>
 #include <tuple>
 #include <random>
 #include <vector>
 
-using ans_type = std::tuple<size_t, size_t, int>;
+using ans_type = std::tuple<size_t, size_t, int64_t>;
+using rect_type = std::tuple<size_t, size_t, size_t, size_t, int64_t>;
 
 ans_type solveCrossing(std::vector<int>& A, size_t low, size_t mid, size_t high) {
-    int l_sum = std::numeric_limits<int>::min();
-    int sum = 0;
+    int64_t l_sum = std::numeric_limits<int64_t>::min();
+    int64_t sum = 0;
     size_t max_left = 0;
     for (size_t i = mid; i >= low && i < high; --i) {
         sum += A[i];
@@ -18,7 +24,7 @@ ans_type solveCrossing(std::vector<int>& A, size_t low, size_t mid, size_t high)
             max_left = i;
         }
     }
-    int r_sum = std::numeric_limits<int>::min();
+    int64_t r_sum = std::numeric_limits<int64_t>::min();
     sum = 0;
     size_t max_right = 0;
     for (size_t i = mid + 1; i <= high; ++i) {
@@ -50,10 +56,10 @@ ans_type solveRecursive(std::vector<int>& A, size_t low, size_t high) {
 }
 
 ans_type solveBruteForce(std::vector<int>& A) {
-    int max_sum = std::numeric_limits<int>::min();
+    int64_t max_sum = std::numeric_limits<int64_t>::min();
     size_t max_left = 0, max_right = 0;
     for (size_t i = 0; i < A.size(); i++) {
-        int sum = 0;
+        int64_t sum = 0;
         for (size_t j = i; j < A.size(); j++) {
             sum += A[j];
             if (max_sum < sum) {
@@ -66,14 +72,358 @@ ans_type solveBruteForce(std::vector<int>& A) {
     return {max_left, max_right, max_sum};
 }
 
+template <typename T>
+ans_type solveKadane(const std::vector<T>& A, size_t low, size_t high) {
+    int64_t max_sum = std::numeric_limits<int64_t>::min();
+    int64_t sum = 0;
+    size_t max_left = low, max_right = low;
+    size_t cur_left = low;
+    for (size_t i = low; i <= high; i++) {
+        if (sum <= 0) {
+            sum = A[i];
+            cur_left = i;
+        } else {
+            sum += A[i];
+        }
+        if (sum > max_sum) {
+            max_sum = sum;
+            max_left = cur_left;
+            max_right = i;
+        }
+    }
+    return {max_left, max_right, max_sum};
+}
+
+template <typename T>
+ans_type solveKadane(const std::vector<T>& A) {
+    assert(!A.empty());
+    return solveKadane(A, 0, A.size() - 1);
+}
+
+// Everything needed to merge two adjacent chunks: the whole sum, the best sum
+// starting at the chunk's left end, the best sum ending at its right end and
+// the best subarray inside.
+struct ChunkSummary {
+    int64_t total;
+    int64_t prefix;
+    size_t prefix_end;
+    int64_t suffix;
+    size_t suffix_begin;
+    ans_type best;
+};
+
+ChunkSummary summarize(const std::vector<int>& A, size_t low, size_t high) {
+    ChunkSummary s {0, std::numeric_limits<int64_t>::min(), low, 0, low,
+                    {low, low, std::numeric_limits<int64_t>::min()}};
+    auto& [best_left, best_right, best_sum] = s.best;
+    int64_t min_before = 0;
+    size_t min_before_end = low;
+    for (size_t i = low; i <= high; i++) {
+        s.total += A[i];
+        if (s.total > s.prefix) {
+            s.prefix = s.total;
+            s.prefix_end = i;
+        }
+        if (s.total - min_before > best_sum) {
+            best_sum = s.total - min_before;
+            best_left = min_before_end;
+            best_right = i;
+        }
+        if (i < high && s.total <= min_before) {
+            min_before = s.total;
+            min_before_end = i + 1;
+        }
+    }
+    s.suffix = s.total - min_before;
+    s.suffix_begin = min_before_end;
+    return s;
+}
+
+ChunkSummary combine(const ChunkSummary& a, const ChunkSummary& b) {
+    ChunkSummary s;
+    s.total = a.total + b.total;
+    if (a.prefix >= a.total + b.prefix) {
+        s.prefix = a.prefix;
+        s.prefix_end = a.prefix_end;
+    } else {
+        s.prefix = a.total + b.prefix;
+        s.prefix_end = b.prefix_end;
+    }
+    if (b.suffix >= b.total + a.suffix) {
+        s.suffix = b.suffix;
+        s.suffix_begin = b.suffix_begin;
+    } else {
+        s.suffix = b.total + a.suffix;
+        s.suffix_begin = a.suffix_begin;
+    }
+    int64_t cross_sum = a.suffix + b.prefix;
+    s.best = a.best;
+    if (cross_sum > std::get<2>(s.best)) {
+        s.best = {a.suffix_begin, b.prefix_end, cross_sum};
+    }
+    if (std::get<2>(b.best) > std::get<2>(s.best)) {
+        s.best = b.best;
+    }
+    return s;
+}
+
+ans_type solveParallel(const std::vector<int>& A, size_t num_threads = std::thread::hardware_concurrency()) {
+    assert(!A.empty());
+    num_threads = std::clamp<size_t>(num_threads, 1, A.size());
+    std::vector<ChunkSummary> summaries(num_threads);
+    std::vector<std::thread> workers;
+    size_t chunk = A.size() / num_threads;
+    for (size_t t = 0; t < num_threads; t++) {
+        size_t low = t * chunk;
+        size_t high = (t + 1 == num_threads) ? A.size() - 1 : low + chunk - 1;
+        workers.emplace_back([&A, &summaries, t, low, high] {
+            summaries[t] = summarize(A, low, high);
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    for (size_t step = 1; step < num_threads; step *= 2) {
+        for (size_t i = 0; i + step < num_threads; i += 2 * step) {
+            summaries[i] = combine(summaries[i], summaries[i + step]);
+        }
+    }
+    return summaries[0].best;
+}
+
+// Segment tree over a fixed series; each node keeps the ChunkSummary of its
+// range, stored in pre-order so a node over [l, r] has its left child right
+// after it and its right child 2 * (mid - l + 1) slots after it.
+struct MaxSubarrayIndex {
+    size_t n;
+    std::vector<ChunkSummary> tree;
+
+    explicit MaxSubarrayIndex(const std::vector<int>& A, size_t num_threads = std::thread::hardware_concurrency())
+            : n {A.size()}, tree(2 * A.size() - 1) {
+        assert(!A.empty());
+        size_t depth = 0;
+        while ((size_t{1} << depth) < num_threads) {
+            depth++;
+        }
+        build(A, 0, 0, n - 1, depth);
+    }
+
+    static ChunkSummary leaf(size_t i, int value) {
+        return {value, value, i, value, i, {i, i, value}};
+    }
+
+    void build(const std::vector<int>& A, size_t v, size_t l, size_t r, size_t depth) {
+        if (l == r) {
+            tree[v] = leaf(l, A[l]);
+            return;
+        }
+        size_t mid = l + (r - l) / 2;
+        size_t lv = v + 1, rv = v + 2 * (mid - l + 1);
+        if (depth > 0) {
+            std::thread left_builder([&] { build(A, lv, l, mid, depth - 1); });
+            build(A, rv, mid + 1, r, depth - 1);
+            left_builder.join();
+        } else {
+            build(A, lv, l, mid, 0);
+            build(A, rv, mid + 1, r, 0);
+        }
+        tree[v] = combine(tree[lv], tree[rv]);
+    }
+
+    void update(size_t i, int value) {
+        assert(i < n);
+        update(0, 0, n - 1, i, value);
+    }
+
+    void update(size_t v, size_t l, size_t r, size_t i, int value) {
+        if (l == r) {
+            tree[v] = leaf(i, value);
+            return;
+        }
+        size_t mid = l + (r - l) / 2;
+        size_t lv = v + 1, rv = v + 2 * (mid - l + 1);
+        if (i <= mid) {
+            update(lv, l, mid, i, value);
+        } else {
+            update(rv, mid + 1, r, i, value);
+        }
+        tree[v] = combine(tree[lv], tree[rv]);
+    }
+
+    ans_type query(size_t low, size_t high) const {
+        assert(low <= high && high < n);
+        return query(0, 0, n - 1, low, high).best;
+    }
+
+    ChunkSummary query(size_t v, size_t l, size_t r, size_t low, size_t high) const {
+        if (low <= l && r <= high) {
+            return tree[v];
+        }
+        size_t mid = l + (r - l) / 2;
+        size_t lv = v + 1, rv = v + 2 * (mid - l + 1);
+        if (high <= mid) {
+            return query(lv, l, mid, low, high);
+        } else if (low > mid) {
+            return query(rv, mid + 1, r, low, high);
+        }
+        return combine(query(lv, l, mid, low, high), query(rv, mid + 1, r, low, high));
+    }
+};
+
+// Collapses every pair of rows (top, bottom) into column sums and runs Kadane
+// over them. Each thread owns the tops top = t, t + T, ... so that the long
+// and short row ranges are spread evenly, and keeps its own column buffer.
+rect_type solveSubmatrix(const std::vector<std::vector<int>>& M,
+                         size_t num_threads = std::thread::hardware_concurrency()) {
+    assert(!M.empty() && !M[0].empty());
+    const size_t R = M.size(), C = M[0].size();
+    num_threads = std::clamp<size_t>(num_threads, 1, R);
+    std::vector<rect_type> results(num_threads, {0, 0, 0, 0, std::numeric_limits<int64_t>::min()});
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < num_threads; t++) {
+        workers.emplace_back([&M, &results, R, C, t, num_threads] {
+            std::vector<int64_t> col_sums(C);
+            auto& best = results[t];
+            for (size_t top = t; top < R; top += num_threads) {
+                std::fill(col_sums.begin(), col_sums.end(), 0);
+                for (size_t bottom = top; bottom < R; bottom++) {
+                    const int* row = M[bottom].data();
+                    int64_t* sums = col_sums.data();
+                    for (size_t c = 0; c < C; c++) {
+                        sums[c] += row[c];
+                    }
+                    auto [left, right, sum] = solveKadane(col_sums, 0, C - 1);
+                    if (sum > std::get<4>(best)) {
+                        best = {top, left, bottom, right, sum};
+                    }
+                }
+            }
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    return *std::max_element(results.begin(), results.end(), [](const rect_type& a, const rect_type& b) {
+        return std::get<4>(a) < std::get<4>(b);
+    });
+}
+
+rect_type solveSubmatrixBruteForce(const std::vector<std::vector<int>>& M) {
+    const size_t R = M.size(), C = M[0].size();
+    std::vector<std::vector<int64_t>> prefix(R + 1, std::vector<int64_t>(C + 1));
+    for (size_t r = 0; r < R; r++) {
+        for (size_t c = 0; c < C; c++) {
+            prefix[r + 1][c + 1] = M[r][c] + prefix[r][c + 1] + prefix[r + 1][c] - prefix[r][c];
+        }
+    }
+    rect_type best {0, 0, 0, 0, std::numeric_limits<int64_t>::min()};
+    for (size_t r1 = 0; r1 < R; r1++) {
+        for (size_t c1 = 0; c1 < C; c1++) {
+            for (size_t r2 = r1; r2 < R; r2++) {
+                for (size_t c2 = c1; c2 < C; c2++) {
+                    int64_t sum = prefix[r2 + 1][c2 + 1] - prefix[r1][c2 + 1] - prefix[r2 + 1][c1] + prefix[r1][c1];
+                    if (sum > std::get<4>(best)) {
+                        best = {r1, c1, r2, c2, sum};
+                    }
+                }
+            }
+        }
+    }
+    return best;
+}
+
 int main() {
     constexpr size_t TRIALS = 10000;
     std::mt19937 gen(std::random_device{}());
     std::uniform_int_distribution<> generator (-100, 100);
 
-    size_t LENGTH = 10;
+    for (size_t i = 0; i < TRIALS; i++) {
+        std::vector<int> v(1 + i % 100);
+        for (auto& n : v) {
+            n = generator(gen);
+        }
+        auto[b_l, b_h, b_s] = solveBruteForce(v);
+        assert(std::get<2>(solveKadane(v)) == b_s);
+        assert(std::get<2>(solveParallel(v, 1 + i % 8)) == b_s);
+    }
+
+    {
+        std::vector<int> v(1000);
+        for (auto& n : v) {
+            n = generator(gen);
+        }
+        MaxSubarrayIndex index(v, 4);
+        std::uniform_int_distribution<size_t> position(0, v.size() - 1);
+        for (size_t i = 0; i < TRIALS; i++) {
+            if (i % 10 == 0) {
+                size_t p = position(gen);
+                v[p] = generator(gen);
+                index.update(p, v[p]);
+            }
+            size_t low = position(gen), high = position(gen);
+            if (low > high) {
+                std::swap(low, high);
+            }
+            auto[q_l, q_h, q_s] = index.query(low, high);
+            assert(low <= q_l && q_l <= q_h && q_h <= high);
+            assert(q_s == std::get<2>(solveKadane(v, low, high)));
+            assert(std::accumulate(v.begin() + q_l, v.begin() + q_h + 1, int64_t{0}) == q_s);
+        }
+    }
+
+    for (size_t i = 0; i < 100; i++) {
+        std::vector<std::vector<int>> M(1 + i % 13, std::vector<int>(1 + i % 7));
+        for (auto& row : M) {
+            for (auto& n : row) {
+                n = generator(gen);
+            }
+        }
+        auto [top, left, bottom, right, sum] = solveSubmatrix(M, 1 + i % 4);
+        assert(sum == std::get<4>(solveSubmatrixBruteForce(M)));
+        int64_t check = 0;
+        for (size_t r = top; r <= bottom; r++) {
+            check += std::accumulate(M[r].begin() + left, M[r].begin() + right + 1, int64_t{0});
+        }
+        assert(check == sum);
+    }
+
     namespace crn = std::chrono;
+    constexpr size_t LARGE_LENGTH = 1u << 24u;
+    std::cout << "Comparing linear algorithms with " << LARGE_LENGTH << " sized input\n";
+    std::vector<int> v(LARGE_LENGTH);
+    for (auto& n : v) {
+        n = generator(gen);
+    }
+    auto t1 = crn::steady_clock::now();
+    auto[r_l, r_h, r_s] = solveRecursive(v, 0, v.size() - 1);
+    auto t2 = crn::steady_clock::now();
+    auto[k_l, k_h, k_s] = solveKadane(v);
+    auto t3 = crn::steady_clock::now();
+    auto[p_l, p_h, p_s] = solveParallel(v);
+    auto t4 = crn::steady_clock::now();
+    assert(r_s == k_s && k_s == p_s);
+    assert(std::accumulate(v.begin() + p_l, v.begin() + p_h + 1, int64_t{0}) == p_s);
+    std::cout << "Recursive: " << crn::duration_cast<crn::milliseconds>(t2 - t1).count() << " ms\n";
+    std::cout << "Kadane: " << crn::duration_cast<crn::milliseconds>(t3 - t2).count() << " ms\n";
+    std::cout << "Parallel Kadane: " << crn::duration_cast<crn::milliseconds>(t4 - t3).count() << " ms\n";
 
+    constexpr size_t IMAGE_SIZE = 512;
+    std::vector<std::vector<int>> image(IMAGE_SIZE, std::vector<int>(IMAGE_SIZE));
+    for (auto& row : image) {
+        for (auto& n : row) {
+            n = generator(gen);
+        }
+    }
+    auto t5 = crn::steady_clock::now();
+    auto[top, left, bottom, right, sum] = solveSubmatrix(image);
+    auto t6 = crn::steady_clock::now();
+    std::cout << "Submatrix of " << IMAGE_SIZE << "x" << IMAGE_SIZE << " image: rows [" << top << ", " << bottom
+              << "], columns [" << left << ", " << right << "], sum " << sum << " in "
+              << crn::duration_cast<crn::milliseconds>(t6 - t5).count() << " ms\n";
+
+    // The sums feed a checksum so the timed calls cannot be optimized away.
+    size_t LENGTH = 10;
+    int64_t checksum = 0;
     while (true) {
         std::cout << "Comparing two algorithms with " << LENGTH << " sized input\n";
         crn::microseconds diff(0);
@@ -83,7 +433,7 @@ int main() {
                 v[j] = generator(gen);
             }
             auto start = crn::steady_clock::now();
-            auto[l, h, s] = solveRecursive(v, 0, v.size() - 1);
+            checksum += std::get<2>(solveRecursive(v, 0, v.size() - 1));
             auto end = crn::steady_clock::now();
             diff += crn::duration_cast<crn::microseconds>(end - start);
         }
@@ -96,14 +446,14 @@ int main() {
                 v[j] = generator(gen);
             }
             auto start = crn::steady_clock::now();
-            auto[l, h, s] = solveBruteForce(v);
+            checksum += std::get<2>(solveBruteForce(v));
             auto end = crn::steady_clock::now();
             diff2 += crn::duration_cast<crn::microseconds>(end - start);
         }
         diff2 /= TRIALS;
         std::cout << "Bruteforce: " << diff2.count() << " us on average.\n";
         if (diff2 > diff) {
-            std::cout << "Recursive finally beats bruteforce, terminating\n";
+            std::cout << "Recursive finally beats bruteforce, terminating (checksum " << checksum << ")\n";
             break;
         } else {
             LENGTH += 10;
@@ -113,5 +463,6 @@ int main() {
 
 
 
+
     return 0;
 }
\ No newline at end of file
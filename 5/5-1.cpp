@@ -1,4 +1,6 @@
 #include <algorithm>
+#include <chrono>
+#include <cstdint>
 #include <cassert>
 #include <cmath>
 #include <iostream>
@@ -6,18 +8,49 @@
 #include <utility>
 #include <vector>
 
-std::mt19937 gen(std::random_device{}());
+#include "monte_carlo.h"
+#include "morris.h"
+
+// Feeds the same stream of random counter indices to count(indices, n) and
+// returns the time taken.
+template <typename Count>
+double feedEvents(size_t num_counters, size_t num_events, uint64_t seed, Count count) {
+    constexpr size_t BLOCK = 1 << 16;
+    Xoshiro256x8 index_gen(seed);
+    std::vector<uint64_t> indices(BLOCK);
+    auto t1 = std::chrono::steady_clock::now();
+    for (size_t begin = 0; begin < num_events; begin += BLOCK) {
+        size_t n = std::min(BLOCK, num_events - begin);
+        fillBelow(index_gen, indices.data(), n, num_counters);
+        count(indices.data(), n);
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    return std::chrono::duration<double>(t2 - t1).count();
+}
+
+template <typename Counter>
+void reportAgainstExact(const MorrisCounters<Counter>& morris, const std::vector<uint64_t>& exact, double seconds) {
+    double total = 0.0, total_error = 0.0;
+    for (size_t i = 0; i < exact.size(); i++) {
+        total += morris.estimate(i);
+        total_error += std::abs(morris.estimate(i) - static_cast<double>(exact[i])) / std::max<double>(exact[i], 1);
+    }
+    std::cout << sizeof(Counter) * 8 << "-bit Morris, base " << morris.base << " : "
+              << morris.counters.size() * sizeof(Counter) / 1e6 << "MB, " << seconds << "s, mean relative error "
+              << total_error / static_cast<double>(exact.size()) << ", total " << total << ", 95% bound "
+              << morris.relativeError(0.05) << '\n';
+}
 
 int main() {
     constexpr size_t N = 100;
-    constexpr size_t trials = 1000;
-    std::uniform_int_distribution<> incr(1, N);
+    constexpr size_t trials = 100'000;
+    MonteCarloOptions options {std::random_device{}()};
+    options.target_half_width = 0.5;
 
-    size_t total_num = 0;
-    for (size_t t = 0; t < trials; t++) {
-        std::vector<size_t> seq(N);
+    auto stats = runTrials(trials, [seq = std::vector<size_t>(N + 1)](Philox& gen) mutable {
+        std::uniform_int_distribution<> incr(1, N);
         size_t cur_num = 0;
-        for (size_t i = 0; i < N; i++) {
+        for (size_t i = 1; i <= N; i++) {
             cur_num += incr(gen);
             seq[i] = cur_num;
         }
@@ -30,9 +63,51 @@ int main() {
                 cur_index++;
             }
         }
-        total_num += cur_num;
+        return static_cast<double>(cur_num);
+    }, options);
+    auto [low, high] = stats.confidenceInterval();
+    std::cout << "Expected value of counter after N increment operations : " << stats.mean << '\n';
+    std::cout << "95% confidence interval : [" << low << ", " << high << "] after " << stats.count
+              << " trials (seed " << options.seed << ")\n";
+
+    constexpr size_t COUNTERS = 100'000;
+    constexpr size_t INCREMENTS = 1000;
+    Xoshiro256x8 gen(options.seed);
+    Xoshiro256pp merge_gen(options.seed);
+    MorrisCounters<uint8_t> first(COUNTERS, 1.08), second(COUNTERS, 1.08);
+    for (size_t i = 0; i < INCREMENTS; i++) {
+        (i < 600 ? first : second).incrementAll(gen);
+    }
+    TrialStats single, merged;
+    for (size_t i = 0; i < COUNTERS; i++) {
+        single.add(first.estimate(i));
     }
-    std::cout << "Expected value of counter after N increment operations : " << static_cast<double>(total_num) / static_cast<double>(trials);
+    first.merge(second, merge_gen);
+    for (size_t i = 0; i < COUNTERS; i++) {
+        merged.add(first.estimate(i));
+    }
+    assert(std::abs(single.mean - 600) < 5 * single.standardError());
+    assert(std::abs(merged.mean - INCREMENTS) < 5 * merged.standardError());
+    assert(std::abs(std::sqrt(single.variance()) / first.standardDeviation(600) - 1) < 0.1);
+    std::cout << "Morris estimate after 600 increments : " << single.mean << " +- " << std::sqrt(single.variance())
+              << ", merged with 400 more : " << merged.mean << " +- " << std::sqrt(merged.variance()) << '\n';
 
+    constexpr size_t NUM_COUNTERS = 10'000'000;
+    constexpr size_t NUM_EVENTS = 200'000'000;
+    std::vector<uint64_t> exact(NUM_COUNTERS);
+    double exact_seconds = feedEvents(NUM_COUNTERS, NUM_EVENTS, options.seed, [&](const uint64_t* indices, size_t n) {
+        for (size_t k = 0; k < n; k++) {
+            exact[indices[k]]++;
+        }
+    });
+    std::cout << "Exact 64-bit : " << NUM_COUNTERS * sizeof(uint64_t) / 1e6 << "MB, " << exact_seconds << "s\n";
+    MorrisCounters<uint16_t> morris16(NUM_COUNTERS, 1.0 + 1.0 / 256);
+    reportAgainstExact(morris16, exact, feedEvents(NUM_COUNTERS, NUM_EVENTS, options.seed, [&](const uint64_t* indices, size_t n) {
+        morris16.increment(indices, n, gen);
+    }));
+    MorrisCounters<uint8_t> morris8(NUM_COUNTERS, 1.08);
+    reportAgainstExact(morris8, exact, feedEvents(NUM_COUNTERS, NUM_EVENTS, options.seed, [&](const uint64_t* indices, size_t n) {
+        morris8.increment(indices, n, gen);
+    }));
 
 }
\ No newline at end of file
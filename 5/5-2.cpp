@@ -1,122 +1,166 @@
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <numeric>
 #include <random>
+#include <thread>
 #include <utility>
 #include <vector>
-#include <unordered_set>
 
-std::mt19937 gen(std::random_device{}());
+#include "monte_carlo.h"
+#include "shuffle.h"
 
-int main() {
-    constexpr size_t N = 100;
-    constexpr size_t trials = 1000;
-    std::uniform_int_distribution<> ind(0, N - 1);
+enum class SearchMode {
+    Deterministic, // scan in index order
+    Random,        // RANDOM-SEARCH: probe uniformly random indices until all have been seen
+    Scrambled,     // SCRAMBLED-SEARCH: scan in the order of a random permutation
+};
 
-    size_t total_count = 0;
-    std::vector<size_t> v(N);
-    std::iota(v.begin(), v.end(), 1);
-    for (size_t t = 0; t < trials; t++) {
-        std::unordered_set<size_t> s;
-        while (s.size() < N) {
-            total_count++;
-            size_t new_index = ind(gen);
-            if (v[new_index] == 1) {
-                break;
-            }
-            s.insert(new_index);
-        }
-    }
-    std::cout << "Expected value of indices of RANDOM-SEARCH : " << static_cast<double>(total_count) / static_cast<double>(trials) << '\n';
+struct SearchResult {
+    size_t index; // some index holding a match, or A.size() if there is none
+    uint64_t probes;
+};
 
-    constexpr size_t K = 3;
-    for (size_t k = 0; k < K; k++) {
-        v[k] = 1;
+// Expected number of probes to find one of k matches among n elements,
+// with the matches placed at random for the deterministic scan (CLRS problem 5-2).
+double expectedProbes(SearchMode mode, size_t n, size_t k) {
+    double harmonic = 0.0;
+    for (size_t i = 1; i <= n; i++) {
+        harmonic += 1.0 / static_cast<double>(i);
     }
-    total_count = 0;
-    for (size_t t = 0; t < trials; t++) {
-        std::unordered_set<size_t> s;
-        while (s.size() < N) {
-            total_count++;
-            size_t new_index = ind(gen);
-            if (v[new_index] == 1) {
-                break;
-            }
-            s.insert(new_index);
-        }
+    switch (mode) {
+        case SearchMode::Random:
+            return k ? static_cast<double>(n) / static_cast<double>(k) : static_cast<double>(n) * harmonic;
+        default:
+            return k ? static_cast<double>(n + 1) / static_cast<double>(k + 1) : static_cast<double>(n);
     }
-    std::cout << "Expected value of indices of RANDOM-SEARCH where " << K << " duplicates : "
-    << static_cast<double>(total_count) / static_cast<double>(trials) << '\n';
+}
 
-    total_count = 0;
-    for (size_t t = 0; t < trials; t++) {
-        std::unordered_set<size_t> s;
-        while (s.size() < N) {
-            total_count++;
-            size_t new_index = ind(gen);
-            if (v[new_index] == N + 1) {
-                break;
-            }
-            s.insert(new_index);
-        }
+// Searches A for an element satisfying pred with num_threads workers. The
+// scans give each worker a contiguous chunk of the (possibly scrambled)
+// order; in random mode every worker draws from its own Philox stream of the
+// seed and records visited indices in a shared bitset, stopping once all
+// have been seen. Workers poll a shared flag and all stop as soon as any of
+// them finds a match, so the index found need not be the first one.
+template <typename T, typename Pred>
+SearchResult parallelSearch(const std::vector<T>& A, Pred pred, SearchMode mode, uint64_t seed,
+                            size_t num_threads = std::thread::hardware_concurrency()) {
+    const size_t n = A.size();
+    num_threads = std::clamp<size_t>(num_threads, 1, std::max<size_t>(n, 1));
+    std::atomic<bool> done {n == 0};
+    std::atomic<size_t> found {n};
+    std::atomic<uint64_t> probes {0};
+    std::vector<size_t> order;
+    std::vector<std::atomic<uint64_t>> visited;
+    std::atomic<size_t> num_visited {0};
+    if (mode == SearchMode::Scrambled) {
+        order.resize(n);
+        std::iota(order.begin(), order.end(), 0);
+        parallelShuffle(order, seed, num_threads);
+    } else if (mode == SearchMode::Random) {
+        visited = std::vector<std::atomic<uint64_t>>((n + 63) / 64);
     }
-    std::cout << "Expected value of indices of RANDOM-SEARCH where zero desired elements : "
-              << static_cast<double>(total_count) / static_cast<double>(trials) << '\n';
 
-    total_count = 0;
-    std::iota(v.begin(), v.end(), 1);
-    for (size_t t = 0; t < trials; t++) {
-        std::shuffle(v.begin(), v.end(), gen);
-        for (size_t i = 0; i < N; i++) {
-            if (v[i] == 1) {
-                total_count += (i + 1);
-                break;
+    auto report = [&](size_t i) {
+        size_t none = n;
+        found.compare_exchange_strong(none, i);
+        done = true;
+    };
+    auto worker = [&](size_t t) {
+        uint64_t local_probes = 0;
+        if (mode == SearchMode::Random) {
+            Philox philox(seed, t);
+            Xoshiro256pp gen(philox());
+            while (!done.load(std::memory_order_relaxed)) {
+                size_t i = uniformBelow(gen, n);
+                local_probes++;
+                if (pred(A[i])) {
+                    report(i);
+                    break;
+                }
+                uint64_t bit = uint64_t{1} << (i % 64);
+                if (!(visited[i / 64].fetch_or(bit, std::memory_order_relaxed) & bit) && ++num_visited == n) {
+                    done = true;
+                }
             }
-        }
-    }
-    std::cout << "Expected value of indices of DETERMINISTIC-SEARCH : " << static_cast<double>(total_count) / static_cast<double>(trials) << '\n';
-
-    std::iota(v.begin(), v.end(), 1);
-    for (size_t k = 0; k < K; k++) {
-        v[k] = 1;
-    }
-    total_count = 0;
-    for (size_t t = 0; t < trials; t++) {
-        std::shuffle(v.begin(), v.end(), gen);
-        for (size_t i = 0; i < N; i++) {
-            if (v[i] == 1) {
-                total_count += (i + 1);
-                break;
+        } else {
+            for (size_t j = n * t / num_threads; j < n * (t + 1) / num_threads; j++) {
+                if (done.load(std::memory_order_relaxed)) {
+                    break;
+                }
+                size_t i = mode == SearchMode::Scrambled ? order[j] : j;
+                local_probes++;
+                if (pred(A[i])) {
+                    report(i);
+                    break;
+                }
             }
         }
+        probes += local_probes;
+    };
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < num_threads; t++) {
+        workers.emplace_back(worker, t);
     }
-    std::cout << "Expected value of indices of DETERMINISTIC-SEARCH where " << K << " duplicates : "
-              << static_cast<double>(total_count) / static_cast<double>(trials) << '\n';
+    worker(0);
+    for (auto& w : workers) {
+        w.join();
+    }
+    return {found, probes};
+}
+
+int main() {
+    constexpr size_t N = 100;
+    constexpr size_t trials = 10'000;
+    constexpr size_t K = 3;
+    const std::pair<SearchMode, const char*> modes[] = {{SearchMode::Deterministic, "DETERMINISTIC-SEARCH"},
+                                                        {SearchMode::Random, "RANDOM-SEARCH"},
+                                                        {SearchMode::Scrambled, "SCRAMBLED-SEARCH"}};
+    MonteCarloOptions options {std::random_device{}()};
 
-    total_count = 0;
-    for (size_t t = 0; t < trials; t++) {
-        total_count += N;
+    for (auto [mode, name] : modes) {
+        for (size_t k : {size_t{1}, K, size_t{0}}) {
+            auto stats = runTrials(trials, [mode, k, v = std::vector<size_t>(N)](Philox& philox) mutable {
+                // The deterministic scan is only random over the input, so shuffle it.
+                Xoshiro256pp gen(philox());
+                std::iota(v.begin(), v.end(), 1);
+                std::fill(v.begin(), v.begin() + k, 0);
+                fisherYates(v.data(), N, gen);
+                auto res = parallelSearch(v, [](size_t x) { return x == 0; }, mode, gen(), 1);
+                assert(k ? v[res.index] == 0 : res.index == N);
+                return static_cast<double>(res.probes);
+            }, options);
+            double expected = expectedProbes(mode, N, k);
+            std::cout << "Expected value of indices of " << name << " where " << k << " desired elements : "
+                      << stats.mean << " +- " << stats.halfWidth() << " (theory " << expected << ")\n";
+            assert(std::abs(stats.mean - expected) < 5 * stats.standardError() + 1e-9);
+        }
     }
-    std::cout << "Expected value of indices of DETERMINISTIC-SEARCH where zero desired elements : "
-              << static_cast<double>(total_count) / static_cast<double>(trials) << '\n';
+    std::cout << "(seed " << options.seed << ")\n";
 
-    std::iota(v.begin(), v.end(), 1);
-    for (size_t k = 0; k < K; k++) {
-        v[k] = 1;
+    constexpr size_t BIG_N = 20'000'000;
+    std::vector<uint32_t> big(BIG_N);
+    std::iota(big.begin(), big.end(), 0);
+    Xoshiro256pp gen(options.seed);
+    std::vector<size_t> targets;
+    for (size_t i = 0; i < 4; i++) {
+        targets.push_back(uniformBelow(gen, BIG_N));
+        big[targets.back()] = BIG_N;
     }
-    total_count = 0;
-    for (size_t t = 0; t < trials; t++) {
-        std::shuffle(v.begin(), v.end(), gen);
-        for (size_t i = 0; i < N; i++) {
-            if (v[i] == 1) {
-                total_count += (i + 1);
-                break;
-            }
+    for (auto [mode, name] : modes) {
+        for (size_t threads : {size_t{1}, size_t{4}}) {
+            auto t1 = std::chrono::steady_clock::now();
+            auto res = parallelSearch(big, [](uint32_t x) { return x == BIG_N; }, mode, options.seed, threads);
+            auto t2 = std::chrono::steady_clock::now();
+            assert(big[res.index] == BIG_N);
+            std::cout << name << " on " << BIG_N << " elements with " << threads << " threads : " << res.probes
+                      << " probes (expected " << expectedProbes(mode, BIG_N, targets.size()) << " for one thread), "
+                      << std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count() << "ms\n";
         }
     }
-    std::cout << "Expected value of indices of SCRAMBLED-SEARCH where " << K << " duplicates : "
-              << static_cast<double>(total_count) / static_cast<double>(trials) << '\n';
 
 }
\ No newline at end of file
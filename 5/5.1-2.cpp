@@ -1,6 +1,14 @@
+#include <algorithm>
+#include <cassert>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <utility>
 #include <random>
 #include <iostream>
+#include <vector>
+
+#include "rng.h"
 
 std::mt19937 gen(std::random_device{}());
 std::bernoulli_distribution dist(0.5);
@@ -21,9 +29,123 @@ int RANDOM(int a, int b) {
     }
 }
 
+// Hands out single random bits, 64 at a time from the underlying generator.
+template <typename Gen>
+struct RandomBitPool {
+    Gen g;
+    uint64_t word = 0;
+    unsigned bits_left = 0;
+    uint64_t bits_used = 0;
+
+    explicit RandomBitPool(Gen g) : g {std::move(g)} {}
+
+    unsigned bit() {
+        if (bits_left == 0) {
+            word = g();
+            bits_left = 64;
+        }
+        unsigned res = word & 1u;
+        word >>= 1u;
+        bits_left--;
+        bits_used++;
+        return res;
+    }
+};
+
+// Uniform value in [0, n) with Lumbroso's Fast Dice Roller: grows a uniform
+// value c in [0, v) one bit at a time and, once v covers the range, either
+// accepts c or keeps the rejected part c - n as a smaller uniform value
+// instead of throwing it away. Uses at most log2(n) + 2 bits on average.
+template <typename Gen>
+uint64_t fastDiceRoller(RandomBitPool<Gen>& pool, uint64_t n) {
+    assert(0 < n && n <= (uint64_t{1} << 62u));
+    uint64_t v = 1, c = 0;
+    while (true) {
+        v <<= 1u;
+        c = (c << 1u) | pool.bit();
+        if (v >= n) {
+            if (c < n) {
+                return c;
+            }
+            v -= n;
+            c -= n;
+        }
+    }
+}
+
+template <typename Gen>
+int64_t RANDOM(RandomBitPool<Gen>& pool, int64_t a, int64_t b) {
+    if (a > b) {
+        std::swap(a, b);
+    }
+    return a + static_cast<int64_t>(fastDiceRoller(pool, static_cast<uint64_t>(b - a) + 1));
+}
+
+// Fills out with count draws of RANDOM(a, b). k draws at a time are taken as
+// the base-n digits of one uniform value in [0, n^k), which spreads the
+// roller's constant overhead over k draws: about log2(n) + 2 / k bits each.
+template <typename Gen>
+void RANDOM(RandomBitPool<Gen>& pool, int64_t a, int64_t b, int64_t* out, size_t count) {
+    if (a > b) {
+        std::swap(a, b);
+    }
+    uint64_t n = static_cast<uint64_t>(b - a) + 1;
+    if (n == 1) {
+        std::fill(out, out + count, a);
+        return;
+    }
+    uint64_t n_k = n;
+    size_t k = 1;
+    while (n_k <= (uint64_t{1} << 62u) / n) {
+        n_k *= n;
+        k++;
+    }
+    for (size_t i = 0; i < count; i += k) {
+        uint64_t digits = fastDiceRoller(pool, n_k);
+        for (size_t j = i; j < i + k && j < count; j++) {
+            out[j] = a + static_cast<int64_t>(digits % n);
+            digits /= n;
+        }
+    }
+}
+
 int main() {
     for (size_t i = 0; i < 30; i++) {
         std::cout << RANDOM(8, 13) << ' ';
     }
+    std::cout << '\n';
+
+    RandomBitPool pool(Xoshiro256pp(std::random_device{}()));
+    constexpr size_t COUNT = 10'000'000;
+    std::vector<int64_t> values(COUNT);
+    std::vector<size_t> histogram(6);
+    auto t1 = std::chrono::steady_clock::now();
+    RANDOM(pool, 8, 13, values.data(), COUNT);
+    auto t2 = std::chrono::steady_clock::now();
+    for (auto n : values) {
+        assert(8 <= n && n <= 13);
+        histogram[n - 8]++;
+    }
+    for (auto h : histogram) {
+        assert(std::abs(static_cast<double>(h) / COUNT * 6.0 - 1.0) < 0.01);
+    }
+    uint64_t bulk_bits = pool.bits_used;
+    auto t3 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < COUNT; i++) {
+        values[i] = RANDOM(pool, 8, 13);
+    }
+    uint64_t single_bits = pool.bits_used - bulk_bits;
+    auto t4 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < COUNT; i++) {
+        values[i] = RANDOM(8, 13);
+    }
+    auto t5 = std::chrono::steady_clock::now();
+
+    namespace crn = std::chrono;
+    std::cout << "Bits per draw of RANDOM(8, 13), bulk : " << static_cast<double>(bulk_bits) / COUNT
+              << ", one at a time : " << static_cast<double>(single_bits) / COUNT << " (log2 6 = " << std::log2(6.0) << ")\n";
+    std::cout << COUNT << " bulk draws with the bit pool : " << crn::duration_cast<crn::milliseconds>(t2 - t1).count() << "ms\n";
+    std::cout << COUNT << " draws with the bit pool, one at a time : " << crn::duration_cast<crn::milliseconds>(t4 - t3).count() << "ms\n";
+    std::cout << COUNT << " draws with recursive RANDOM : " << crn::duration_cast<crn::milliseconds>(t5 - t4).count() << "ms\n";
 
 }
\ No newline at end of file
@@ -1,5 +1,20 @@
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <random>
 #include <iostream>
+#include <numeric>
+#include <vector>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+#include "alias.h"
+#include "permutation_test.h"
+#include "rng.h"
 
 std::mt19937 gen(std::random_device{}());
 std::bernoulli_distribution BIASED_RANDOM(0.8);
@@ -14,6 +29,79 @@ bool UNBIASED_RANDOM() {
     }
 }
 
+// Gathers the bits of x selected by mask into the low bits of the result.
+inline uint64_t compressBits(uint64_t x, uint64_t mask) {
+#if defined(__BMI2__)
+    return _pext_u64(x, mask);
+#else
+    uint64_t res = 0;
+    for (unsigned i = 0; mask; mask &= mask - 1, i++) {
+        res |= ((x >> std::countr_zero(mask)) & 1u) << i;
+    }
+    return res;
+#endif
+}
+
+// Packs bits, least significant first, into 64-bit words.
+struct BitWriter {
+    std::vector<uint64_t>& words;
+    size_t size = 0;
+
+    explicit BitWriter(std::vector<uint64_t>& words) : words {words} {}
+
+    void put(uint64_t bits, unsigned count) {
+        if (count == 0) {
+            return;
+        }
+        unsigned offset = size % 64;
+        if (offset == 0) {
+            words.push_back(bits);
+        } else {
+            words.back() |= bits << offset;
+            if (offset + count > 64) {
+                words.push_back(bits >> (64 - offset));
+            }
+        }
+        size += count;
+    }
+};
+
+// Peres' iterated von Neumann extractor on the first n bits of in. Each word
+// yields 32 pairs at once: differing pairs give the von Neumann output, the
+// pair XORs and the values of equal pairs are extracted again recursively,
+// up to depth more levels. The output rate approaches the input entropy as
+// depth grows; depth 0 is plain von Neumann.
+inline void peres(const uint64_t* in, size_t n, unsigned depth, BitWriter& out) {
+    constexpr uint64_t EVEN = 0x5555555555555555u;
+    std::vector<uint64_t> xors, equals;
+    BitWriter xor_writer(xors), equal_writer(equals);
+    for (size_t w = 0; 2 * w * 32 + 1 < n; w++) {
+        size_t valid = std::min<size_t>(64, n - 64 * w) & ~size_t{1};
+        uint64_t pairs = valid == 64 ? EVEN : EVEN & ((uint64_t{1} << valid) - 1);
+        uint64_t first = in[w] & pairs;
+        uint64_t diff = (first ^ (in[w] >> 1u)) & pairs;
+        out.put(compressBits(first, diff), std::popcount(diff));
+        if (depth > 0) {
+            xor_writer.put(compressBits(diff, pairs), std::popcount(pairs));
+            equal_writer.put(compressBits(first, pairs & ~diff), std::popcount(pairs & ~diff));
+        }
+    }
+    if (depth > 0) {
+        peres(xors.data(), xor_writer.size, depth - 1, out);
+        peres(equals.data(), equal_writer.size, depth - 1, out);
+    }
+}
+
+// Runs the extractor over in block by block and returns the number of output bits.
+inline size_t extractUnbiased(const std::vector<uint64_t>& in, std::vector<uint64_t>& out, unsigned depth = 8) {
+    constexpr size_t BLOCK_WORDS = 1024;
+    BitWriter writer(out);
+    for (size_t w = 0; w < in.size(); w += BLOCK_WORDS) {
+        peres(in.data() + w, 64 * std::min(BLOCK_WORDS, in.size() - w), depth, writer);
+    }
+    return writer.size;
+}
+
 int main() {
 
     size_t count = 0;
@@ -24,4 +112,137 @@ int main() {
         }
     }
     std::cout << static_cast<double>(count) / static_cast<double>(trials) << '\n';
+
+    // Biased input: each bit is 1 with probability 52429 / 65536 ~ 0.8.
+    constexpr size_t WORDS = size_t{1} << 20u;
+    Xoshiro256pp g(std::random_device{}());
+    std::vector<uint64_t> input(WORDS);
+    for (auto& word : input) {
+        for (unsigned i = 0; i < 64; i += 4) {
+            uint64_t r = g();
+            for (unsigned j = 0; j < 4; j++) {
+                word |= static_cast<uint64_t>(((r >> (16 * j)) & 0xFFFFu) < 52429u) << (i + j);
+            }
+        }
+    }
+    const double input_bits = 64.0 * WORDS;
+    const double p = 52429.0 / 65536.0;
+    std::cout << "Entropy per input bit : " << -p * std::log2(p) - (1 - p) * std::log2(1 - p) << '\n';
+    for (unsigned depth : {0u, 1u, 2u, 4u, 8u, 12u}) {
+        std::vector<uint64_t> output;
+        auto t1 = std::chrono::steady_clock::now();
+        size_t bits = extractUnbiased(input, output, depth);
+        auto t2 = std::chrono::steady_clock::now();
+        size_t ones = 0;
+        for (size_t i = 0; i < bits / 64; i++) {
+            ones += std::popcount(output[i]);
+        }
+        double ones_ratio = static_cast<double>(ones) / (64.0 * (bits / 64));
+        assert(std::abs(ones_ratio - 0.5) < 0.001);
+        double seconds = std::chrono::duration<double>(t2 - t1).count();
+        std::cout << "Depth " << depth << " : " << bits / input_bits << " output bits per input bit, "
+                  << bits / seconds / 1e6 << " Mbit/s out, ones ratio " << ones_ratio << '\n';
+    }
+
+    // BIASED_RANDOM is the two-outcome case of an alias table.
+    Xoshiro256x8 lanes(std::random_device{}());
+    constexpr size_t DRAWS = 10'000'000;
+    std::vector<uint32_t> draws(DRAWS);
+    AliasTable coin({0.2, 0.8});
+    coin(lanes, draws.data(), DRAWS);
+    double heads = static_cast<double>(std::accumulate(draws.begin(), draws.end(), uint64_t{0})) / DRAWS;
+    std::cout << "Alias table coin with p = 0.8 : " << heads << '\n';
+    assert(std::abs(heads - 0.8) < 0.001);
+
+    // Goodness of fit of draws against the current weights of a table.
+    auto fit = [&](const AliasTable& table, bool bulk) {
+        std::vector<uint64_t> count(table.size());
+        if (bulk) {
+            table(lanes, draws.data(), DRAWS);
+        }
+        for (size_t i = 0; i < DRAWS; i++) {
+            count[bulk ? draws[i] : table(g)]++;
+        }
+        double chi2 = 0.0;
+        size_t bins = 0;
+        for (size_t i = 0; i < table.size(); i++) {
+            double expected = table.probability(i) * DRAWS;
+            if (expected == 0.0) {
+                assert(count[i] == 0);
+                continue;
+            }
+            chi2 += (count[i] - expected) * (count[i] - expected) / expected;
+            bins++;
+        }
+        return chiSquareZ(chi2, static_cast<double>(bins - 1));
+    };
+    constexpr size_t SMALL = 1000;
+    std::vector<double> small_weights(SMALL);
+    for (size_t i = 0; i < SMALL; i++) {
+        small_weights[i] = i % 10 == 0 ? 0.0 : uniformDouble(g);
+    }
+    AliasTable dynamic(small_weights);
+    double z = fit(dynamic, true);
+    std::cout << "Alias table over " << SMALL << " outcomes, fit z : " << z << '\n';
+    assert(z < 5.0);
+    // A few updates up and down are absorbed by rejection and the overflow list.
+    for (size_t u = 0; u < 40; u++) {
+        dynamic.update(uniformBelow(g, SMALL), 1.5 * uniformDouble(g));
+    }
+    assert(!dynamic.exact() && dynamic.rebuilds == 1);
+    double bulk_z = fit(dynamic, true), single_z = fit(dynamic, false);
+    std::cout << "After 40 updates without a rebuild, fit z : " << bulk_z << " bulk, " << single_z << " one at a time\n";
+    assert(bulk_z < 5.0 && single_z < 5.0);
+    for (size_t u = 0; u < 100'000; u++) {
+        dynamic.update(uniformBelow(g, SMALL), uniformDouble(g) * (u % 2 ? 2.0 : 0.5));
+    }
+    z = fit(dynamic, true);
+    std::cout << "After 100000 updates and " << dynamic.rebuilds - 1 << " rebuilds, fit z : " << z << '\n';
+    assert(z < 5.0);
+
+    // A million outcomes with Zipf-like weights in random order, some zero.
+    constexpr size_t OUTCOMES = 1'000'000;
+    std::vector<double> weights(OUTCOMES);
+    for (size_t i = 0; i < OUTCOMES; i++) {
+        weights[i] = i % 10 == 0 ? 0.0 : 1.0 / static_cast<double>(1 + uniformBelow(g, OUTCOMES));
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    std::discrete_distribution<uint32_t> discrete(weights.begin(), weights.end());
+    auto t2 = std::chrono::steady_clock::now();
+    AliasTable serial(weights, 1);
+    auto t3 = std::chrono::steady_clock::now();
+    AliasTable table(weights);
+    auto t4 = std::chrono::steady_clock::now();
+    // The table implies every probability exactly, whatever the thread count.
+    std::vector<uint64_t> implied(OUTCOMES);
+    for (size_t i = 0; i < OUTCOMES; i++) {
+        auto [threshold, alias] = table.columns[i];
+        assert(threshold == serial.columns[i].threshold && alias == serial.columns[i].alias);
+        implied[i] += threshold;
+        implied[alias] += (uint64_t{1} << 32u) - threshold;
+    }
+    for (size_t i = 0; i < OUTCOMES; i++) {
+        assert(std::abs(std::ldexp(static_cast<double>(implied[i]), -32) / OUTCOMES - table.probability(i)) < 1e-9);
+    }
+
+    uint64_t checksum = 0;
+    auto t5 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < DRAWS; i++) {
+        checksum += discrete(gen);
+    }
+    auto t6 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < DRAWS; i++) {
+        checksum += table(g);
+    }
+    auto t7 = std::chrono::steady_clock::now();
+    table(lanes, draws.data(), DRAWS);
+    auto t8 = std::chrono::steady_clock::now();
+    namespace crn = std::chrono;
+    std::cout << "Categorical distribution over " << OUTCOMES << " outcomes (checksum " << checksum << ")\n";
+    std::cout << "std::discrete_distribution : build " << crn::duration_cast<crn::milliseconds>(t2 - t1).count()
+              << "ms, " << DRAWS << " draws " << crn::duration_cast<crn::milliseconds>(t6 - t5).count() << "ms\n";
+    std::cout << "Alias table : build " << crn::duration_cast<crn::milliseconds>(t3 - t2).count() << "ms on one thread, "
+              << crn::duration_cast<crn::milliseconds>(t4 - t3).count() << "ms on all, " << DRAWS << " draws "
+              << crn::duration_cast<crn::milliseconds>(t7 - t6).count() << "ms, bulk "
+              << crn::duration_cast<crn::milliseconds>(t8 - t7).count() << "ms\n";
 }
\ No newline at end of file
@@ -1,27 +1,45 @@
+#include <cassert>
 #include <cmath>
 #include <iostream>
 #include <numeric>
 #include <random>
 #include <vector>
 
-std::mt19937 gen(std::random_device{}());
+#include "monte_carlo.h"
+#include "permutation_stats.h"
+#include "shuffle.h"
 
 int main() {
     constexpr size_t N = 1000;
-    constexpr size_t trials = 1000;
+    constexpr size_t trials = 100'000;
 
-    std::vector<int> hats(N);
-    std::iota(hats.begin(), hats.end(), 1);
-    size_t count = 0;
-    for (size_t i = 0; i < trials; i++) {
-        auto shuffled_hats = hats;
-        std::shuffle(shuffled_hats.begin(), shuffled_hats.end(), gen);
-        for (size_t j = 0; j < N; j++) {
-            if (shuffled_hats[j] == hats[j]) {
-                count++;
-            }
+    MonteCarloOptions options {std::random_device{}()};
+    auto stats = runTrials(trials, [hats = std::vector<int>(N), kernel = PermutationStatsKernel {}](Philox& philox) mutable {
+        Xoshiro256pp gen(philox());
+        std::iota(hats.begin(), hats.end(), 1);
+        fisherYates(hats.data(), N, gen);
+        return static_cast<double>(kernel(hats, 1).fixed_points);
+    }, options);
+    auto [low, high] = stats.confidenceInterval();
+
+    std::cout << "Average matched count : " << stats.mean << '\n';
+    std::cout << "95% confidence interval : [" << low << ", " << high << "] (seed " << options.seed << ")\n";
+
+    // Blocks are the independent replicates the error is measured over, so use many small ones.
+    options.block_size = 256;
+    for (size_t n : {size_t{10}, N}) {
+        for (auto sampling : {Sampling::Independent, Sampling::Antithetic, Sampling::Stratified, Sampling::Sobol}) {
+            options.sampling = sampling;
+            auto res = estimate(20'480, [n, hats = std::vector<int>(n), kernel = PermutationStatsKernel {}](auto& gen) mutable {
+                std::iota(hats.begin(), hats.end(), 1);
+                fisherYates(hats.data(), n, gen);
+                return static_cast<double>(kernel(hats, 1).fixed_points);
+            }, options);
+            std::cout << "Average matched count for n = " << n << ", " << toString(sampling) << " : " << res.mean
+                      << " +- " << res.halfWidth() << ", effective sample size " << res.effective_sample_size << " of "
+                      << res.trials << '\n';
+            assert(std::abs(res.mean - 1.0) < 5 * res.standard_error);
         }
     }
-    std::cout << "Average matched count : " << static_cast<double>(count) / static_cast<double>(trials) << '\n';
 
 }
\ No newline at end of file
@@ -1,19 +1,23 @@
+#include <cassert>
 #include <cmath>
 #include <iostream>
 #include <numeric>
 #include <random>
 #include <vector>
 
-std::mt19937 gen(std::random_device{}());
+#include "monte_carlo.h"
+#include "permutation_stats.h"
+#include "shuffle.h"
 
+// Merges the sorted runs A[p, q) and A[q, r) through the caller's buffer B
+// and returns the number of pairs the merge puts back in order.
 template <typename T>
-size_t merge(std::vector<T>& A, size_t p, size_t q, size_t r) {
+size_t merge(std::vector<T>& A, std::vector<T>& B, size_t p, size_t q, size_t r) {
     size_t i = p;
     size_t j = q;
     size_t count = 0;
-    std::vector<T> B (r - p);
-    for (size_t k = 0; k < B.size(); k++) {
-        if (A[i] < A[j] || j >= r) {
+    for (size_t k = p; k < r; k++) {
+        if (j >= r || (i < q && A[i] <= A[j])) {
             B[k] = A[i];
             i++;
         } else {
@@ -22,41 +26,75 @@ size_t merge(std::vector<T>& A, size_t p, size_t q, size_t r) {
             count += (q - i);
         }
     }
-    std::copy(A.begin() + p, A.begin() + r, B.begin());
+    std::copy(B.begin() + p, B.begin() + r, A.begin() + p);
     return count;
 }
 
 template <typename T>
-size_t inversionsHelper(std::vector<T>& A, size_t p, size_t r) {
-    if (p < r) {
+size_t inversionsHelper(std::vector<T>& A, std::vector<T>& B, size_t p, size_t r) {
+    if (r - p > 1) {
         size_t q = p + (r - p) / 2;
         size_t count = 0;
-        count += inversionsHelper(A, p, q);
-        count += inversionsHelper(A, q + 1, r);
-        count += merge(A, p, q, r);
+        count += inversionsHelper(A, B, p, q);
+        count += inversionsHelper(A, B, q, r);
+        count += merge(A, B, p, q, r);
         return count;
     }
     return 0;
 }
 
+// Sorts A. B is scratch space, resized to A.size() if needed.
 template <typename T>
-size_t inversions(std::vector<T>& A) {
-    return inversionsHelper(A, 0, A.size() - 1);
+size_t inversions(std::vector<T>& A, std::vector<T>& B) {
+    B.resize(A.size());
+    return inversionsHelper(A, B, 0, A.size());
 }
 
 int main() {
     constexpr size_t N = 1000;
-    constexpr size_t trials = 1000;
+    constexpr size_t trials = 100'000;
 
-    std::vector<int> hats(N);
-    std::iota(hats.begin(), hats.end(), 1);
-    size_t count = 0;
-    for (size_t i = 0; i < trials; i++) {
-        auto shuffled_hats = hats;
-        std::shuffle(shuffled_hats.begin(), shuffled_hats.end(), gen);
-        count += inversions(shuffled_hats);
+    MonteCarloOptions options {std::random_device{}()};
+    auto stats = runTrials(trials, [hats = std::vector<int>(N), kernel = PermutationStatsKernel {}](Philox& philox) mutable {
+        Xoshiro256pp gen(philox());
+        std::iota(hats.begin(), hats.end(), 1);
+        fisherYates(hats.data(), N, gen);
+        return static_cast<double>(kernel(hats, 1).inversions);
+    }, options);
+    auto [low, high] = stats.confidenceInterval();
+
+    std::mt19937 gen(options.seed);
+    PermutationStatsKernel kernel;
+    std::vector<int> buffer;
+    for (size_t n = 1; n < 200; n++) {
+        std::vector<int> hats(n);
+        std::iota(hats.begin(), hats.end(), 0);
+        std::shuffle(hats.begin(), hats.end(), gen);
+        auto fused = kernel(hats);
+        size_t expected = 0;
+        for (size_t i = 0; i < n; i++) {
+            for (size_t j = i + 1; j < n; j++) {
+                expected += hats[i] > hats[j];
+            }
+        }
+        size_t cycles = 0;
+        std::vector<bool> seen(n);
+        for (size_t i = 0; i < n; i++) {
+            if (!seen[i]) {
+                cycles++;
+                for (size_t j = i; !seen[j]; j = hats[j]) {
+                    seen[j] = true;
+                }
+            }
+        }
+        assert(fused.inversions == expected);
+        assert(fused.cycles == cycles);
+        assert(inversions(hats, buffer) == expected);
+        assert(std::is_sorted(hats.begin(), hats.end()));
     }
-    std::cout << "Average inversion count : " << static_cast<double>(count) / static_cast<double>(trials) << '\n';
+
+    std::cout << "Average inversion count : " << stats.mean << '\n';
+    std::cout << "95% confidence interval : [" << low << ", " << high << "] (seed " << options.seed << ")\n";
     std::cout << "N * (N - 1) / 4 : " << N * (N - 1) / 4.0 << '\n';
 
 }
\ No newline at end of file
@@ -1,10 +1,13 @@
+#include <cassert>
 #include <cmath>
 #include <iostream>
 #include <numeric>
 #include <random>
 #include <vector>
 
-std::mt19937 gen(std::random_device{}());
+#include "monte_carlo.h"
+#include "permutation_stats.h"
+#include "shuffle.h"
 
 size_t hiringCost(const std::vector<int>& v) {
     int best = 0;
@@ -20,16 +23,44 @@ size_t hiringCost(const std::vector<int>& v) {
 
 int main() {
     constexpr size_t N = 1000;
-    constexpr size_t trials = 1000;
-    size_t cost = 0;
+    constexpr size_t trials = 100'000;
 
-    for (size_t i = 0; i < trials; i++) {
-        std::vector<int> candidates(N);
+    MonteCarloOptions options {std::random_device{}()};
+    auto stats = runTrials(trials, [candidates = std::vector<int>(N), kernel = PermutationStatsKernel {}](Philox& philox) mutable {
+        Xoshiro256pp gen(philox());
         std::iota(candidates.begin(), candidates.end(), 1);
-        std::shuffle(candidates.begin(), candidates.end(), gen);
-        cost += hiringCost(candidates);
-    }
+        fisherYates(candidates.data(), N, gen);
+        auto cost = kernel(candidates, 1).records;
+        assert(cost == hiringCost(candidates));
+        return static_cast<double>(cost);
+    }, options);
+    auto [low, high] = stats.confidenceInterval();
 
-    std::cout << "Average hiring cost : " << static_cast<double>(cost) / static_cast<double>(trials) << '\n';
+    std::cout << "Average hiring cost : " << stats.mean << '\n';
+    std::cout << "95% confidence interval : [" << low << ", " << high << "] (seed " << options.seed << ")\n";
     std::cout << "ln n : " << std::log(N) << '\n';
+
+    // The same estimate with variance reduction; the trial draws straight
+    // from the generator it is handed so the sampling scheme can shape it.
+    // Blocks are the independent replicates the error is measured over, so use many small ones.
+    options.block_size = 256;
+    for (size_t n : {size_t{10}, N}) {
+        double harmonic = 0.0;
+        for (size_t i = 1; i <= n; i++) {
+            harmonic += 1.0 / static_cast<double>(i);
+        }
+        std::cout << "H_" << n << " : " << harmonic << '\n';
+        for (auto sampling : {Sampling::Independent, Sampling::Antithetic, Sampling::Stratified, Sampling::Sobol}) {
+            options.sampling = sampling;
+            auto res = estimate(20'480, [n, candidates = std::vector<int>(n), kernel = PermutationStatsKernel {}](auto& gen) mutable {
+                std::iota(candidates.begin(), candidates.end(), 1);
+                fisherYates(candidates.data(), n, gen);
+                return static_cast<double>(kernel(candidates, 1).records);
+            }, options);
+            std::cout << "Average hiring cost for n = " << n << ", " << toString(sampling) << " : " << res.mean << " +- "
+                      << res.halfWidth() << ", effective sample size " << res.effective_sample_size << " of "
+                      << res.trials << '\n';
+            assert(std::abs(res.mean - harmonic) < 5 * res.standard_error);
+        }
+    }
 }
\ No newline at end of file
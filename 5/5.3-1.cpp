@@ -5,19 +5,33 @@
 #include <utility>
 #include <vector>
 
+#include "permutation_test.h"
+#include "rng.h"
+
+template <typename T, typename Gen>
+void randomizeInPlace(T* v, size_t n, Gen& gen) {
+    std::swap(v[0], v[uniformBelow(gen, n)]);
+    for (size_t i = 1; i < n; i++) {
+        std::swap(v[i], v[uniformInt(gen, i, n - 1)]);
+    }
+}
+
 int main() {
     constexpr size_t N = 20;
     std::vector<int> v (N);
-    std::mt19937 gen(std::random_device{}());
+    Xoshiro256pp gen(std::random_device{}());
     std::iota(v.begin(), v.end(), 1);
-    std::uniform_int_distribution<> dist(0, N - 1);
-    std::swap(v[0], v[dist(gen)]);
-    for (size_t i = 1; i < N; i++) {
-        std::uniform_int_distribution<> dist_local(i, N - 1);
-        std::swap(v[i], v[dist_local(gen)]);
-    }
+    randomizeInPlace(v.data(), N, gen);
     for (auto n : v) {
         std::cout << n << ' ';
     }
+    std::cout << '\n';
+
+    uint64_t seed = std::random_device{}();
+    auto res = testPermutations(6, 2'000'000, [](uint8_t* p, size_t n, Xoshiro256pp& g) {
+        randomizeInPlace(p, n, g);
+    }, seed);
+    std::cout << res << " (seed " << seed << ")\n";
+    assert(res.passed());
 
 }
\ No newline at end of file
@@ -5,18 +5,33 @@
 #include <utility>
 #include <vector>
 
+#include "permutation_test.h"
+#include "rng.h"
+
+template <typename T, typename Gen>
+void permuteWithoutIdentity(T* v, size_t n, Gen& gen) {
+    for (size_t i = 0; i + 1 < n; i++) {
+        std::swap(v[i], v[uniformInt(gen, i + 1, n - 1)]);
+    }
+}
+
 int main() {
     constexpr size_t N = 20;
     std::vector<int> v (N);
-    std::mt19937 gen(std::random_device{}());
+    Xoshiro256pp gen(std::random_device{}());
     std::iota(v.begin(), v.end(), 1);
-    std::uniform_int_distribution<> dist(0, N - 1);
-    for (size_t i = 0; i < N - 1; i++) {
-        std::uniform_int_distribution<> dist_local(i + 1, N - 1);
-        std::swap(v[i], v[dist_local(gen)]);
-    }
+    permuteWithoutIdentity(v.data(), N, gen);
     for (auto n : v) {
         std::cout << n << ' ';
     }
+    std::cout << '\n';
+
+    // Only the (n - 1)! cyclic permutations come out, so the rank test fails.
+    uint64_t seed = std::random_device{}();
+    auto res = testPermutations(6, 2'000'000, [](uint8_t* p, size_t n, Xoshiro256pp& g) {
+        permuteWithoutIdentity(p, n, g);
+    }, seed);
+    std::cout << res << " (seed " << seed << ")\n";
+    assert(!res.passed());
 
 }
\ No newline at end of file
@@ -5,17 +5,33 @@
 #include <utility>
 #include <vector>
 
+#include "permutation_test.h"
+#include "rng.h"
+
+template <typename T, typename Gen>
+void permuteWithAll(T* v, size_t n, Gen& gen) {
+    for (size_t i = 0; i < n; i++) {
+        std::swap(v[i], v[uniformBelow(gen, n)]);
+    }
+}
+
 int main() {
     constexpr size_t N = 20;
     std::vector<int> v (N);
-    std::mt19937 gen(std::random_device{}());
+    Xoshiro256pp gen(std::random_device{}());
     std::iota(v.begin(), v.end(), 1);
-    std::uniform_int_distribution<> dist(0, N - 1);
-    for (size_t i = 0; i < N; i++) {
-        std::swap(v[i], v[dist(gen)]);
-    }
+    permuteWithAll(v.data(), N, gen);
     for (auto n : v) {
         std::cout << n << ' ';
     }
+    std::cout << '\n';
+
+    // n^n equally likely swap sequences cannot spread evenly over n! orders.
+    uint64_t seed = std::random_device{}();
+    auto res = testPermutations(6, 2'000'000, [](uint8_t* p, size_t n, Xoshiro256pp& g) {
+        permuteWithAll(p, n, g);
+    }, seed);
+    std::cout << res << " (seed " << seed << ")\n";
+    assert(!res.passed());
 
 }
\ No newline at end of file
@@ -5,20 +5,37 @@
 #include <utility>
 #include <vector>
 
+#include "permutation_test.h"
+#include "rng.h"
+
+template <typename T, typename Gen>
+void permuteByCyclic(T* v, size_t n, Gen& gen) {
+    std::vector<T> u(v, v + n);
+    auto offset = uniformBelow(gen, n);
+    for (size_t i = 0; i < n; i++) {
+        auto dst = (i + offset) % n;
+        v[dst] = u[i];
+    }
+}
+
 int main() {
     constexpr size_t N = 20;
     std::vector<int> v (N);
-    std::mt19937 gen(std::random_device{}());
+    Xoshiro256pp gen(std::random_device{}());
     std::iota(v.begin(), v.end(), 1);
-    std::uniform_int_distribution<> dist(0, N - 1);
-    auto u = v;
-    auto offset = dist(gen);
-    for (size_t i = 0; i < N; i++) {
-        auto dst = (i + offset) % N;
-        u[dst] = v[i];
-    }
-    for (auto n : u) {
+    permuteByCyclic(v.data(), N, gen);
+    for (auto n : v) {
         std::cout << n << ' ';
     }
+    std::cout << '\n';
+
+    // Every element lands in every position equally often, but only n of the
+    // n! orders can occur, which the rank test catches.
+    uint64_t seed = std::random_device{}();
+    auto res = testPermutations(6, 2'000'000, [](uint8_t* p, size_t n, Xoshiro256pp& g) {
+        permuteByCyclic(p, n, g);
+    }, seed);
+    std::cout << res << " (seed " << seed << ")\n";
+    assert(res.rank_z > 100.0);
 
 }
\ No newline at end of file
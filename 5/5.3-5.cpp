@@ -1,24 +1,22 @@
 #include <algorithm>
 #include <cassert>
+#include <cmath>
 #include <iostream>
 #include <random>
 #include <utility>
 #include <vector>
 
+#include "collision.h"
+
 int main() {
     constexpr size_t N = 20;
     constexpr size_t trials = 1000;
     std::mt19937 gen(std::random_device{}());
     std::uniform_int_distribution<> dist(1, std::pow(N, 3));
+    CollisionDetector priorities(std::pow(N, 3) + 1, N);
     size_t unique_count = 0;
     for (size_t t = 0; t < trials; t++) {
-        std::vector<int> v(N);
-        for (size_t i = 0; i < N - 1; i++) {
-            v[i] = dist(gen);
-        }
-        std::sort(v.begin(), v.end());
-        v.erase(std::unique(v.begin(), v.end()), v.end());
-        if (v.size() == N) {
+        if (!hasCollision(priorities, N, 2, [&] { return dist(gen); })) {
             unique_count++;
         }
     }
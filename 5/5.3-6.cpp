@@ -1,22 +1,121 @@
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <iostream>
 #include <random>
 #include <numeric>
 #include <utility>
 #include <vector>
 
+#include "feistel.h"
+#include "permutation_test.h"
+#include "rng.h"
+#include "shuffle.h"
+
 int main() {
     constexpr size_t N = 20;
     std::vector<int> v (N);
-    std::mt19937 gen(std::random_device{}());
+    Xoshiro256pp gen(std::random_device{}());
     std::iota(v.begin(), v.end(), 0);
     for (size_t i = 0; i < N; i++) {
-        std::uniform_int_distribution<> dist(i, N - 1);
-        std::swap(v[i], v[dist(gen)]);
+        std::swap(v[i], v[uniformInt(gen, i, N - 1)]);
     }
 
     for (auto n : v) {
         std::cout << n << ' ';
     }
 
+    std::cout << '\n';
+
+    // The scatter path on every order of 5 elements (leaf size 1) and on
+    // the positions in 200, each sample with its own seed and thread count.
+    constexpr uint64_t seed = 12345;
+    auto scatter = [](size_t max_threads, size_t leaf_size) {
+        return [=](uint8_t* p, size_t n, Xoshiro256pp& g) {
+            std::vector<uint8_t> u(p, p + n);
+            uint64_t shuffle_seed = g();
+            parallelShuffle(u, shuffle_seed, 1 + g() % max_threads, leaf_size);
+            std::copy(u.begin(), u.end(), p);
+        };
+    };
+    auto res = testPermutations(5, 200'000, scatter(2, 1), seed);
+    std::cout << "Parallel scatter shuffle of 5 : " << res << '\n';
+    assert(res.passed());
+    res = testPermutations(200, 200'000, scatter(4, 16), seed);
+    std::cout << "Parallel scatter shuffle of 200 : " << res << '\n';
+    assert(res.passed());
+
+    constexpr size_t LARGE_N = size_t{1} << 25u;
+    std::vector<uint32_t> large(LARGE_N);
+    std::iota(large.begin(), large.end(), 0);
+    std::mt19937 mt(seed);
+    auto t1 = std::chrono::steady_clock::now();
+    std::shuffle(large.begin(), large.end(), mt);
+    auto t2 = std::chrono::steady_clock::now();
+    fisherYates(large.data(), large.size(), gen);
+    auto t3 = std::chrono::steady_clock::now();
+    parallelShuffle(large, seed);
+    auto t4 = std::chrono::steady_clock::now();
+    namespace crn = std::chrono;
+    std::cout << "Shuffling " << LARGE_N << " elements\n";
+    std::cout << "std::shuffle : " << crn::duration_cast<crn::milliseconds>(t2 - t1).count() << "ms\n";
+    std::cout << "Fisher-Yates with xoshiro256++ : " << crn::duration_cast<crn::milliseconds>(t3 - t2).count() << "ms\n";
+    std::cout << "Parallel scatter shuffle : " << crn::duration_cast<crn::milliseconds>(t4 - t3).count() << "ms\n";
+    std::sort(large.begin(), large.end());
+    for (size_t i = 0; i < LARGE_N; i++) {
+        assert(large[i] == i);
+    }
+
+    // A Feistel permutation is a bijection with a working inverse, and with a
+    // fresh key per sample its orders are as uniform as the shuffles'.
+    for (uint64_t n : {1, 2, 3, 5, 16, 17, 1000}) {
+        FeistelPermutation perm(n, seed + n);
+        std::vector<uint64_t> in(n), out(n), back(n);
+        std::iota(in.begin(), in.end(), 0);
+        perm(in.data(), out.data(), n);
+        perm.inverse(out.data(), back.data(), n);
+        for (uint64_t i = 0; i < n; i++) {
+            assert(out[i] == perm(i));
+            assert(perm.inverse(out[i]) == i);
+            assert(back[i] == i);
+        }
+        std::sort(out.begin(), out.end());
+        assert(out == in);
+    }
+    auto feistel = [](uint8_t* p, size_t n, Xoshiro256pp& g) {
+        FeistelPermutation perm(n, g());
+        for (size_t i = 0; i < n; i++) {
+            p[i] = static_cast<uint8_t>(perm(i));
+        }
+    };
+    res = testPermutations(6, 2'000'000, feistel, seed);
+    std::cout << "Feistel permutation of 6 : " << res << '\n';
+    assert(res.passed());
+    res = testPermutations(200, 200'000, feistel, seed);
+    std::cout << "Feistel permutation of 200 : " << res << '\n';
+    assert(res.passed());
+
+    // 10^11 IDs would take 800GB as a vector; the permutation is a few words.
+    constexpr uint64_t HUGE_N = 100'000'000'000;
+    constexpr size_t QUERIES = size_t{1} << 24u;
+    FeistelPermutation huge(HUGE_N, seed);
+    std::vector<uint64_t> ids(QUERIES), images(QUERIES), preimages(QUERIES);
+    for (size_t i = 0; i < QUERIES; i++) {
+        ids[i] = i * (HUGE_N / QUERIES);
+    }
+    auto t5 = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < QUERIES; i++) {
+        images[i] = huge(ids[i]);
+    }
+    auto t6 = std::chrono::steady_clock::now();
+    huge(ids.data(), preimages.data(), QUERIES);
+    auto t7 = std::chrono::steady_clock::now();
+    assert(preimages == images);
+    huge.inverse(images.data(), preimages.data(), QUERIES);
+    assert(preimages == ids);
+    std::cout << "Mapping " << QUERIES << " of " << HUGE_N << " indices with a " << sizeof(huge)
+              << " byte permutation\n";
+    std::cout << "One at a time : " << crn::duration_cast<crn::milliseconds>(t6 - t5).count() << "ms\n";
+    std::cout << "Batched : " << crn::duration_cast<crn::milliseconds>(t7 - t6).count() << "ms\n";
+
 }
\ No newline at end of file
@@ -1,8 +1,17 @@
+#include <algorithm>
+#include <bit>
 #include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <limits>
 #include <random>
 #include <utility>
 #include <unordered_set>
+#include <vector>
+
+#include "rng.h"
 
 std::mt19937 gen(std::random_device{}());
 
@@ -24,11 +33,312 @@ std::unordered_set<size_t> randomSample(size_t m, size_t n) {
     }
 }
 
+// Open-addressing set of nonzero 64-bit keys in one flat array. Probes
+// start at the top bits of a Fibonacci hash of the key.
+struct FlatSet {
+    std::vector<uint64_t> slots;
+    uint64_t mask;
+    unsigned shift;
+
+    explicit FlatSet(size_t capacity) {
+        size_t size = std::bit_ceil(2 * std::max<size_t>(capacity, 1));
+        slots.assign(size, 0);
+        mask = size - 1;
+        shift = 64 - std::countr_zero(size);
+    }
+
+    // Returns false if key was already present.
+    bool insert(uint64_t key) {
+        for (uint64_t i = (key * 0x9E3779B97F4A7C15u) >> shift; ; i++) {
+            auto& slot = slots[i & mask];
+            if (slot == key) {
+                return false;
+            }
+            if (slot == 0) {
+                slot = key;
+                return true;
+            }
+        }
+    }
+};
+
+// RANDOM-SAMPLE unrolled into a loop (Floyd's algorithm): m distinct values of
+// {1, ..., n}, in the order they were picked.
+template <typename Gen>
+std::vector<uint64_t> randomSampleFloyd(uint64_t m, uint64_t n, Gen& g) {
+    assert(m <= n);
+    FlatSet seen(m);
+    std::vector<uint64_t> res;
+    res.reserve(m);
+    for (uint64_t j = n - m + 1; j <= n && j != 0; j++) {
+        auto i = static_cast<uint64_t>(uniformInt(g, 1, static_cast<int64_t>(j)));
+        if (!seen.insert(i)) {
+            i = j;
+            seen.insert(i);
+        }
+        res.push_back(i);
+    }
+    return res;
+}
+
+// Vitter's Algorithm A: picks m of {0, ..., n - 1} in increasing order in
+// O(n) time by drawing the length of each skip directly.
+template <typename Gen, typename Emit>
+void sequentialSampleA(uint64_t m, uint64_t n, uint64_t next, Gen& g, Emit&& emit) {
+    double top = static_cast<double>(n - m);
+    double n_real = static_cast<double>(n);
+    while (m >= 2) {
+        double v = uniformDouble(g);
+        uint64_t s = 0;
+        double quot = top / n_real;
+        while (quot > v) {
+            s++;
+            top -= 1.0;
+            n_real -= 1.0;
+            quot = quot * top / n_real;
+        }
+        next += s;
+        emit(next++);
+        n_real -= 1.0;
+        m--;
+    }
+    if (m == 1) {
+        emit(next + static_cast<uint64_t>(n_real * uniformDouble(g)));
+    }
+}
+
+// Vitter's Algorithm D ("An efficient algorithm for sequential random
+// sampling", 1987): picks m of {0, ..., n - 1} and emits them in increasing
+// order with O(1) extra memory and O(m) expected time. Skips are drawn by
+// rejection from a continuous approximation; once m is no longer small
+// compared to n it falls back to Algorithm A.
+template <typename Gen, typename Emit>
+void sequentialSample(uint64_t m, uint64_t n, Gen& g, Emit&& emit) {
+    assert(m <= n);
+    constexpr int64_t ALPHA_INV = 13;
+    auto unit = [&g] { return 1.0 - uniformDouble(g); };
+    uint64_t next = 0;
+    double m_real = static_cast<double>(m);
+    double n_real = static_cast<double>(n);
+    double m_inv = 1.0 / m_real;
+    double v_prime = std::exp(std::log(unit()) * m_inv);
+    uint64_t qu1 = n - m + 1;
+    double qu1_real = n_real - m_real + 1.0;
+    uint64_t threshold = ALPHA_INV * m;
+    while (m > 1 && threshold < n) {
+        double m_min1_inv = 1.0 / (m_real - 1.0);
+        uint64_t s;
+        while (true) {
+            double x;
+            while (true) {
+                x = n_real * (1.0 - v_prime);
+                s = static_cast<uint64_t>(x);
+                if (s < qu1) {
+                    break;
+                }
+                v_prime = std::exp(std::log(unit()) * m_inv);
+            }
+            double u = unit();
+            double neg_s_real = -static_cast<double>(s);
+            double y1 = std::exp(std::log(u * n_real / qu1_real) * m_min1_inv);
+            v_prime = y1 * (1.0 - x / n_real) * (qu1_real / (neg_s_real + qu1_real));
+            if (v_prime <= 1.0) {
+                break;
+            }
+            double y2 = 1.0;
+            double top = n_real - 1.0;
+            double bottom;
+            uint64_t limit;
+            if (m - 1 > s) {
+                bottom = n_real - m_real;
+                limit = n - s;
+            } else {
+                bottom = n_real + neg_s_real - 1.0;
+                limit = qu1;
+            }
+            for (uint64_t t = n - 1; t >= limit; t--) {
+                y2 = y2 * top / bottom;
+                top -= 1.0;
+                bottom -= 1.0;
+            }
+            if (n_real / (n_real - x) >= y1 * std::exp(std::log(y2) * m_min1_inv)) {
+                v_prime = std::exp(std::log(unit()) * m_min1_inv);
+                break;
+            }
+            v_prime = std::exp(std::log(unit()) * m_inv);
+        }
+        next += s;
+        emit(next++);
+        n = n - s - 1;
+        n_real = n_real - static_cast<double>(s) - 1.0;
+        m--;
+        m_real -= 1.0;
+        m_inv = m_min1_inv;
+        qu1 -= s;
+        qu1_real -= static_cast<double>(s);
+        threshold -= ALPHA_INV;
+    }
+    if (m > 1) {
+        sequentialSampleA(m, n, next, g, emit);
+    } else if (m == 1) {
+        emit(next + static_cast<uint64_t>(n_real * v_prime));
+    }
+}
+
+// Li's Algorithm L: keeps a uniform sample of k items from a stream of
+// unknown length. After the reservoir fills, the gap to the next accepted
+// item is drawn directly, so only O(k log(N / k)) random numbers are used
+// and the caller can skip the items in between via nextIndex().
+template <typename T, typename Gen>
+struct ReservoirSampler {
+    size_t k;
+    Gen g;
+    std::vector<T> reservoir;
+    uint64_t seen = 0;
+    uint64_t next = 0;
+    double w = 1.0;
+
+    ReservoirSampler(size_t k, Gen g) : k {k}, g {std::move(g)} {
+        assert(k > 0);
+        reservoir.reserve(k);
+    }
+
+    double unit() {
+        return 1.0 - uniformDouble(g);
+    }
+
+    void advance() {
+        w *= std::exp(std::log(unit()) / static_cast<double>(k));
+        double gap = std::floor(std::log(unit()) / std::log1p(-w));
+        next = gap < static_cast<double>(std::numeric_limits<uint64_t>::max() - next) ?
+               next + 1 + static_cast<uint64_t>(gap) : std::numeric_limits<uint64_t>::max();
+    }
+
+    // Index of the next stream item that will be kept.
+    uint64_t nextIndex() const {
+        return seen < k ? seen : next;
+    }
+
+    void offer(const T& item) {
+        if (seen < k) {
+            reservoir.push_back(item);
+            if (seen + 1 == k) {
+                next = seen;
+                advance();
+            }
+        } else if (seen == next) {
+            reservoir[uniformBelow(g, k)] = item;
+            advance();
+        }
+        seen++;
+    }
+
+    // Accounts for count items that were skipped without being offered.
+    void skip(uint64_t count) {
+        seen += count;
+    }
+};
+
 int main() {
     constexpr size_t N = 20;
     auto v = randomSample(8, N);
     for (auto n : v) {
         std::cout << n << ' ';
     }
+    std::cout << '\n';
+
+    Xoshiro256pp g(12345);
+    constexpr size_t TRIALS = 100'000;
+    constexpr size_t D_N = 100;
+    std::vector<size_t> floyd_count(N + 1), d_count(D_N), a_count(N), reservoir_count(N);
+    for (size_t t = 0; t < TRIALS; t++) {
+        auto sample = randomSampleFloyd(8, N, g);
+        assert(sample.size() == 8);
+        for (auto n : sample) {
+            assert(1 <= n && n <= N);
+            floyd_count[n]++;
+        }
+        uint64_t previous = 0, count = 0;
+        sequentialSample(3, D_N, g, [&](uint64_t i) {
+            assert(i < D_N && (count == 0 || i > previous));
+            previous = i;
+            count++;
+            d_count[i]++;
+        });
+        assert(count == 3);
+        count = 0;
+        sequentialSampleA(8, N, 0, g, [&](uint64_t i) {
+            assert(i < N && (count == 0 || i > previous));
+            previous = i;
+            count++;
+            a_count[i]++;
+        });
+        assert(count == 8);
+        ReservoirSampler<size_t, Xoshiro256pp> reservoir(4, Xoshiro256pp(g()));
+        for (size_t i = 0; i < N; i++) {
+            reservoir.offer(i);
+        }
+        for (auto n : reservoir.reservoir) {
+            reservoir_count[n]++;
+        }
+    }
+    // Every element should be picked with probability m / n; allow five standard deviations.
+    auto close = [](size_t count, double expected) {
+        return std::abs(static_cast<double>(count) - expected) < 5.0 * std::sqrt(expected);
+    };
+    for (size_t i = 0; i < N; i++) {
+        assert(close(floyd_count[i + 1], TRIALS * 8.0 / N));
+        assert(close(a_count[i], TRIALS * 8.0 / N));
+        assert(close(reservoir_count[i], TRIALS * 4.0 / N));
+    }
+    for (size_t i = 0; i < D_N; i++) {
+        assert(close(d_count[i], TRIALS * 3.0 / D_N));
+    }
+
+    // Pairs drawn by Algorithm D itself (2 of 30 stays above the fallback threshold).
+    constexpr size_t P_N = 30;
+    std::vector<size_t> pair_count(P_N * P_N);
+    for (size_t t = 0; t < 2 * TRIALS; t++) {
+        std::vector<uint64_t> pair;
+        sequentialSample(2, P_N, g, [&](uint64_t i) { pair.push_back(i); });
+        pair_count[pair[0] * P_N + pair[1]]++;
+    }
+    double expected = 2.0 * TRIALS / (P_N * (P_N - 1) / 2);
+    double chi2 = 0.0;
+    for (size_t i = 0; i < P_N; i++) {
+        for (size_t j = i + 1; j < P_N; j++) {
+            double diff = static_cast<double>(pair_count[i * P_N + j]) - expected;
+            chi2 += diff * diff / expected;
+        }
+    }
+    // 0.999 quantile of chi-square with 434 degrees of freedom is about 530.
+    std::cout << "Chi-square over pairs from Algorithm D : " << chi2 << '\n';
+    assert(chi2 < 530.0);
+
+    namespace crn = std::chrono;
+    constexpr uint64_t POPULATION = 10'000'000'000;
+    constexpr uint64_t SAMPLE = 10'000'000;
+    auto t1 = crn::steady_clock::now();
+    uint64_t last = 0, emitted = 0;
+    sequentialSample(SAMPLE, POPULATION, g, [&](uint64_t i) {
+        assert(emitted == 0 || i > last);
+        last = i;
+        emitted++;
+    });
+    auto t2 = crn::steady_clock::now();
+    assert(emitted == SAMPLE && last < POPULATION);
+    auto floyd = randomSampleFloyd(SAMPLE, POPULATION, g);
+    auto t3 = crn::steady_clock::now();
+    ReservoirSampler<uint64_t, Xoshiro256pp> reservoir(1000, Xoshiro256pp(g()));
+    for (uint64_t i = 0; i < POPULATION; i = reservoir.nextIndex()) {
+        reservoir.skip(i - reservoir.seen);
+        reservoir.offer(i);
+    }
+    auto t4 = crn::steady_clock::now();
+    std::cout << "Sampling " << SAMPLE << " of " << POPULATION << '\n';
+    std::cout << "Algorithm D (sorted, O(1) memory) : " << crn::duration_cast<crn::milliseconds>(t2 - t1).count() << "ms\n";
+    std::cout << "Floyd with a flat set : " << crn::duration_cast<crn::milliseconds>(t3 - t2).count() << "ms\n";
+    std::cout << "Algorithm L, 1000 of a " << POPULATION << " item stream : "
+              << crn::duration_cast<crn::milliseconds>(t4 - t3).count() << "ms\n";
 
 }
\ No newline at end of file
@@ -3,35 +3,31 @@
 #include <cmath>
 #include <iostream>
 #include <random>
-#include <unordered_map>
 #include <utility>
 #include <vector>
 
+#include "collision.h"
+#include "exact_distributions.h"
+
 std::mt19937 gen(std::random_device{}());
 std::uniform_int_distribution<> birthday(1, 365);
 
 int main() {
     constexpr size_t N = 94;
     constexpr size_t trials = 1000;
+    CollisionDetector days(366, N);
     size_t same_birthday_count = 0;
     for (size_t t = 0; t < trials; t++) {
-        std::vector<int> people(N);
-        std::unordered_map<int, int> freq;
-        for (size_t i = 0; i < N; i++) {
-            people[i] = birthday(gen);
-            freq[people[i]]++;
-        }
-        int max_freq = 0;
-        for (const auto& [day, ppl] : freq) {
-            max_freq = std::max(max_freq, ppl);
-        }
-        if (max_freq >= 3) {
+        if (hasCollision(days, N, 3, [] { return birthday(gen); })) {
             same_birthday_count++;
         }
     }
 
+    double probability = static_cast<double>(same_birthday_count) / static_cast<double>(trials);
+    double exact = 1.0 - noKCollisionProbability(N, 365, 3);
     std::cout << "Probability that at least 3 people have the same birthday with " << N <<
-    " peoples : " << static_cast<double>(same_birthday_count) / static_cast<double>(trials) << '\n';
-
+    " peoples : " << probability << '\n';
+    std::cout << "Exact : " << exact << '\n';
+    assert(std::abs(probability - exact) < 5 * std::sqrt(exact * (1 - exact) / trials));
 
 }
\ No newline at end of file
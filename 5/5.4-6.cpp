@@ -1,11 +1,18 @@
 #include <algorithm>
+#include <array>
 #include <cassert>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <iostream>
 #include <random>
 #include <utility>
 #include <vector>
 
+#include "exact_distributions.h"
+#include "monte_carlo.h"
+
 std::mt19937 gen(std::random_device{}());
 
 int main() {
@@ -35,4 +42,77 @@ int main() {
                                                        static_cast<double>(trials) << '\n';
     std::cout << "n ((n-1)/n)^(n-1) : " << (N * std::pow(static_cast<double>(N - 1) / N, N - 1)) << '\n';
 
+    auto occupied = occupiedBinsDistribution(N, N);
+    double exact_empty = N - mean(occupied);
+    assert(std::abs(exact_empty - N * std::pow(static_cast<double>(N - 1) / N, N)) < 1e-9);
+    std::cout << "Distribution of empty bins :";
+    for (size_t empty = 25; empty <= 45; empty += 5) {
+        std::cout << " P(" << empty << ") = " << occupied[N - empty];
+    }
+    std::cout << '\n';
+
+    // Empty bins again, one trial at a time and then 16 trials per batch.
+    constexpr size_t LANES = 16;
+    constexpr uint64_t many_trials = 1'000'000;
+    MonteCarloOptions options {std::random_device{}()};
+    options.num_threads = 1;
+    auto t1 = std::chrono::steady_clock::now();
+    auto stats = runTrials(many_trials, [bin = std::vector<uint8_t>(N)](Philox& philox) mutable {
+        Xoshiro256pp g(philox());
+        std::fill(bin.begin(), bin.end(), 0);
+        for (size_t i = 0; i < N; i++) {
+            bin[uniformBelow(g, N)] = 1;
+        }
+        return static_cast<double>(std::count(bin.begin(), bin.end(), 0));
+    }, options);
+    auto t2 = std::chrono::steady_clock::now();
+    auto batched = runLaneTrials<LANES>(many_trials, [](Xoshiro256x8& g, std::array<double, LANES>& out) {
+        // Toss i belongs to lane i % LANES, and lane l of bin b lives at
+        // b * LANES + l, so the final count is a vertical sum. Two tosses
+        // come from each 32-bit half word, one per 16-bit quarter by
+        // Lemire's method, in a branch-free loop; the scatter into the bins
+        // is scalar anyway and redraws the few quarters that fell in the
+        // rejection zone (65536 mod N values) on the way.
+        constexpr size_t TOSSES = N * LANES;
+        constexpr uint32_t ZONE = 65536 % N;
+        alignas(64) std::array<uint64_t, TOSSES / 4> words;
+        alignas(64) std::array<uint32_t, TOSSES / 2> halves;
+        alignas(64) std::array<uint32_t, TOSSES> products;
+        alignas(64) std::array<uint8_t, TOSSES> filled {};
+        g.fill(words.data(), words.size());
+        std::memcpy(halves.data(), words.data(), sizeof(words));
+        for (size_t h = 0; h < TOSSES / 2; h++) {
+            products[h] = (halves[h] & 0xFFFFu) * N;
+            products[TOSSES / 2 + h] = (halves[h] >> 16u) * N;
+        }
+        for (size_t i = 0; i < TOSSES; i += LANES) {
+            for (size_t l = 0; l < LANES; l++) {
+                uint32_t m = products[i + l];
+                while ((m & 0xFFFFu) < ZONE) [[unlikely]] {
+                    uint64_t word;
+                    g.fill(&word, 1);
+                    m = static_cast<uint32_t>(word & 0xFFFFu) * N;
+                }
+                filled[(m >> 16u) * LANES + l] = 1;
+            }
+        }
+        alignas(64) std::array<uint8_t, LANES> empty {};
+        for (size_t b = 0; b < N; b++) {
+            for (size_t l = 0; l < LANES; l++) {
+                empty[l] += 1u - filled[b * LANES + l];
+            }
+        }
+        for (size_t l = 0; l < LANES; l++) {
+            out[l] = empty[l];
+        }
+    }, options);
+    auto t3 = std::chrono::steady_clock::now();
+
+    auto ns = [](auto d) { return std::chrono::duration<double, std::nano>(d).count() / many_trials; };
+    std::cout << "Empty bins : " << stats.mean << " +- " << stats.halfWidth() << " (" << ns(t2 - t1)
+              << "ns per trial), batched : " << batched.mean << " +- " << batched.halfWidth() << " ("
+              << ns(t3 - t2) << "ns per trial)\n";
+    assert(std::abs(stats.mean - exact_empty) < 5 * stats.standardError());
+    assert(std::abs(batched.mean - exact_empty) < 5 * batched.standardError());
+
 }
\ No newline at end of file
@@ -1,32 +1,57 @@
 #include <algorithm>
+#include <array>
 #include <cassert>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <random>
 #include <utility>
 #include <vector>
 
-std::mt19937 gen(std::random_device{}());
-std::uniform_int_distribution<> birthday(1, 365);
+#include "collision.h"
+#include "exact_distributions.h"
+#include "monte_carlo.h"
 
 int main() {
     constexpr size_t N = 23;
-    constexpr size_t trials = 1000;
-    size_t same_birthday_count = 0;
-    for (size_t t = 0; t < trials; t++) {
-        std::vector<int> people(N);
-        for (size_t i = 0; i < N; i++) {
-            people[i] = birthday(gen);
+    constexpr size_t trials = 1'000'000;
+    MonteCarloOptions options {std::random_device{}()};
+    auto t1 = std::chrono::steady_clock::now();
+    auto stats = runTrials(trials, [days = CollisionDetector(365, N)](Philox& gen) mutable {
+        return hasCollision(days, N, 2, [&gen] { return uniformBelow(gen, 365); }) ? 1.0 : 0.0;
+    }, options);
+    auto t2 = std::chrono::steady_clock::now();
+    auto [low, high] = stats.confidenceInterval();
+
+    // 16 rooms per batch, one per lane. With so few people, comparing every
+    // pair of birthdays lane by lane beats any table and is pure vector code.
+    constexpr size_t LANES = 16;
+    auto batched = runLaneTrials<LANES>(trials, [](Xoshiro256x8& gen, std::array<double, LANES>& out) {
+        alignas(64) std::array<uint32_t, N * LANES> birthdays;
+        fillBelow32(gen, birthdays.data(), birthdays.size(), 365);
+        alignas(64) std::array<uint32_t, LANES> shared {};
+        for (size_t i = 1; i < N; i++) {
+            for (size_t j = 0; j < i; j++) {
+                for (size_t l = 0; l < LANES; l++) {
+                    shared[l] |= static_cast<uint32_t>(birthdays[i * LANES + l] == birthdays[j * LANES + l]);
+                }
+            }
         }
-        std::sort(people.begin(), people.end());
-        people.erase(std::unique(people.begin(), people.end()), people.end());
-        if (people.size() < N) {
-            same_birthday_count++;
+        for (size_t l = 0; l < LANES; l++) {
+            out[l] = shared[l];
         }
-    }
+    }, options);
+    auto t3 = std::chrono::steady_clock::now();
 
-    std::cout << "Probability that at least 2 people have the same birthday : " << static_cast<double>(same_birthday_count) /
-            static_cast<double>(trials) << '\n';
+    std::cout << "Probability that at least 2 people have the same birthday : " << stats.mean << '\n';
+    std::cout << "95% confidence interval : [" << low << ", " << high << "] (seed " << options.seed << ")\n";
+    std::cout << "Batched : " << batched.mean << " +- " << batched.halfWidth() << '\n';
+    auto ns = [](auto d) { return std::chrono::duration<double, std::nano>(d).count() / trials; };
+    std::cout << ns(t2 - t1) << "ns per trial, batched : " << ns(t3 - t2) << "ns per trial\n";
+    double exact = 1.0 - noKCollisionProbability(N, 365, 2);
+    assert(std::abs(stats.mean - exact) < 5 * stats.standardError());
+    assert(std::abs(batched.mean - exact) < 5 * batched.standardError());
     std::cout << "1 - exp(-k(k-1)/2n) : " << 1.0 - std::exp(-static_cast<double>(N) * (N - 1) / (2.0 * 365));
 
 
@@ -1,31 +1,121 @@
 #include <algorithm>
+#include <array>
 #include <cassert>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <random>
 #include <utility>
 #include <vector>
 
-std::mt19937 gen(std::random_device{}());
+#include "exact_distributions.h"
+#include "monte_carlo.h"
+
+// Occupancy of N bins as one bit per bin plus a running count of nonempty
+// bins, so a toss costs O(1) and 10^8 bins fit in 12.5MB.
+struct BinOccupancy {
+    std::vector<uint64_t> bits;
+    size_t num_bins = 0;
+    size_t occupied = 0;
+
+    void reset(size_t n) {
+        num_bins = n;
+        occupied = 0;
+        bits.assign((n + 63) / 64, 0);
+    }
+
+    // Returns whether the bin was empty before the toss.
+    bool toss(size_t bin) {
+        uint64_t mask = uint64_t{1} << (bin % 64);
+        uint64_t& word = bits[bin / 64];
+        bool was_empty = !(word & mask);
+        word |= mask;
+        occupied += was_empty;
+        return was_empty;
+    }
+
+    bool full() const {
+        return occupied == num_bins;
+    }
+};
+
+// Number of tosses until every one of n bins holds a ball. Bins are drawn a
+// batch at a time and their words prefetched, since for large n nearly every
+// toss misses the cache; the batch that fills the last bin is cut short.
+template <typename Gen>
+uint64_t tossesToFill(size_t n, BinOccupancy& bins, Gen& gen) {
+    constexpr size_t BATCH = 32;
+    bins.reset(n);
+    uint64_t tosses = 0;
+    std::array<size_t, BATCH> batch;
+    while (!bins.full()) {
+        for (auto& bin : batch) {
+            bin = uniformBelow(gen, n);
+            __builtin_prefetch(&bins.bits[bin / 64], 1);
+        }
+        for (size_t i = 0; i < BATCH && !bins.full(); i++) {
+            bins.toss(batch[i]);
+            tosses++;
+        }
+    }
+    return tosses;
+}
+
+// Prints quantiles of (T - N ln N) / N, which tends to a standard Gumbel,
+// next to the exact ones.
+void printDistribution(std::vector<double> samples, size_t N) {
+    std::sort(samples.begin(), samples.end());
+    const double n = static_cast<double>(N);
+    auto exact = couponCollectorDistribution(N);
+    std::cout << "Quantiles of tosses for N = " << N << " (normalized | exact | Gumbel limit):\n";
+    for (double q : {0.01, 0.1, 0.25, 0.5, 0.75, 0.9, 0.99}) {
+        double tosses = samples[static_cast<size_t>(q * static_cast<double>(samples.size() - 1))];
+        std::cout << "  " << q << " : " << tosses << " (" << (tosses - n * std::log(n)) / n << " | "
+                  << quantile(exact, q) << " | " << -std::log(-std::log(q)) << ")\n";
+    }
+}
 
 int main() {
     constexpr size_t N = 100;
-    constexpr size_t trials = 1000;
-    std::uniform_int_distribution<> toss(0, N - 1);
-    size_t toss_count = 0;
-    for (size_t t = 0; t < trials; t++) {
-        std::vector<int> bin(N);
-        while (true) {
-            bin[toss(gen)] = 1;
-            toss_count++;
-            if (std::all_of(bin.cbegin(), bin.cend(), [](int i){return i;})) {
-                break;
-            }
+    constexpr size_t trials = 100'000;
+    MonteCarloOptions options {std::random_device{}()};
+    auto samples = sampleTrials(trials, [bins = BinOccupancy {}](Philox& philox) mutable {
+        Xoshiro256pp gen(philox());
+        return static_cast<double>(tossesToFill(N, bins, gen));
+    }, options);
+    TrialStats stats;
+    for (auto s : samples) {
+        stats.add(s);
+    }
+    auto [low, high] = stats.confidenceInterval();
+
+    std::cout << "Expected number of tosses : " << stats.mean << '\n';
+    std::cout << "95% confidence interval : [" << low << ", " << high << "] (seed " << options.seed << ")\n";
+    std::cout << "N ln N : " << N * std::log(N) << '\n';
+    double harmonic = 0.0;
+    for (size_t i = 1; i <= N; i++) {
+        harmonic += 1.0 / static_cast<double>(i);
+    }
+    std::cout << "N H_N : " << N * harmonic << '\n';
+    assert(std::abs(stats.mean - N * harmonic) < 5 * stats.standardError());
+    for (size_t bins : {0, 1, 2, 50, 200, 365, 500, 2000}) {
+        double expected = 0.0;
+        for (size_t i = 1; i <= bins; i++) {
+            expected += static_cast<double>(bins) / static_cast<double>(i);
         }
+        assert(std::abs(mean(couponCollectorDistribution(bins)) - expected) < 1e-9 * std::max(expected, 1.0));
     }
+    printDistribution(samples, N);
 
-    std::cout << "Expected number of tosses : " << static_cast<double>(toss_count) /
-            static_cast<double>(trials) << '\n';
-    std::cout << "N ln N : " << N * std::log(N);
+    constexpr size_t BIG_N = 100'000'000;
+    BinOccupancy big_bins;
+    Xoshiro256pp gen(options.seed);
+    auto t1 = std::chrono::steady_clock::now();
+    uint64_t big_tosses = tossesToFill(BIG_N, big_bins, gen);
+    auto t2 = std::chrono::steady_clock::now();
+    std::cout << "Filled " << BIG_N << " bins with " << big_tosses << " tosses ("
+              << (static_cast<double>(big_tosses) - BIG_N * std::log(BIG_N)) / BIG_N << " normalized) in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count() << "ms\n";
 
 }
\ No newline at end of file
@@ -1,34 +1,247 @@
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <cassert>
+#include <chrono>
 #include <cmath>
+#include <cstdint>
 #include <iostream>
+#include <numeric>
 #include <random>
+#include <thread>
 #include <utility>
+#include <vector>
 
-std::mt19937 gen(std::random_device{}());
+#include "exact_distributions.h"
+#include "monte_carlo.h"
+
+// Runs of ones in a stretch of a bitstream; prefix and suffix are the runs
+// touching its ends, which join up with the neighbouring stretches.
+struct RunSummary {
+    uint64_t length;
+    uint64_t prefix;
+    uint64_t suffix;
+    uint64_t best;
+};
+
+RunSummary combine(const RunSummary& a, const RunSummary& b) {
+    return {a.length + b.length,
+            a.prefix == a.length ? a.length + b.prefix : a.prefix,
+            b.suffix == b.length ? b.length + a.suffix : b.suffix,
+            std::max({a.best, b.best, a.suffix + b.prefix})};
+}
+
+// Whether w holds a run of at least len ones, 1 <= len <= 64. After each
+// x &= x >> k the set bits mark where runs k longer start, so the length
+// doubles per step.
+inline bool hasRun(uint64_t w, unsigned len) {
+    unsigned have = 1;
+    for (; 2 * have <= len; have *= 2) {
+        w &= w >> have;
+    }
+    if (have < len) {
+        w &= w >> (len - have);
+    }
+    return w != 0;
+}
+
+// Scans a bitstream word by word, least significant bit first. A word only
+// gets looked into when it could hold a run longer than the best so far.
+struct RunScanner {
+    uint64_t length = 0;
+    uint64_t prefix = 0;
+    uint64_t current = 0;
+    uint64_t best = 0;
+    bool all_ones = true;
+
+    // The low valid bits of w are the next bits of the stream, the rest are zero.
+    void feed(uint64_t w, unsigned valid = 64) {
+        length += valid;
+        unsigned low = std::min<unsigned>(std::countr_one(w), valid);
+        if (low == valid) {
+            current += valid;
+            return;
+        }
+        enter(low);
+        while (best < valid && hasRun(w, static_cast<unsigned>(best) + 1)) {
+            best++;
+        }
+        current = std::countl_one(w << (64 - valid));
+    }
+
+    // Steps over words that hold no run above the best: only the run coming
+    // in through the first word and the one leaving through the last matter.
+    void skip(uint64_t first, uint64_t last, uint64_t num_words) {
+        length += 64 * num_words;
+        enter(std::countr_one(first));
+        current = std::countl_one(last);
+    }
+
+    void enter(uint64_t low) {
+        if (all_ones) {
+            prefix = current + low;
+            all_ones = false;
+        }
+        best = std::max(best, current + low);
+    }
+
+    RunSummary summary() const {
+        return {length, all_ones ? current : prefix, current, std::max(best, current)};
+    }
+};
+
+// Longest-run summary of the first n bits of words, one word at a time.
+RunSummary summarizeRuns(const uint64_t* words, uint64_t n) {
+    RunScanner scanner;
+    for (uint64_t i = 0; 64 * i < n; i++) {
+        auto valid = static_cast<unsigned>(std::min<uint64_t>(64, n - 64 * i));
+        scanner.feed(valid == 64 ? words[i] : words[i] & ((uint64_t{1} << valid) - 1), valid);
+    }
+    return scanner.summary();
+}
+
+// Same, but blocks of eight words are first screened for runs of
+// min(best + 1, 32) ones, inside each word and across each boundary via the
+// word made of the top half of one word and the bottom half of the next.
+// Any longer run crossing a boundary has 32 ones in that window. The
+// screening loops have no branches and a shift amount shared by all words,
+// so they compile to vector code; the few blocks that pass go through feed.
+RunSummary summarizeRunsBlocked(const uint64_t* words, uint64_t n) {
+    constexpr size_t BLOCK = 8;
+    RunScanner scanner;
+    uint64_t full_blocks = n / (64 * BLOCK);
+    for (uint64_t b = 0; b < full_blocks; b++) {
+        const uint64_t* w = words + b * BLOCK;
+        auto len = static_cast<unsigned>(std::min<uint64_t>(scanner.best + 1, 32));
+        alignas(64) std::array<uint64_t, 2 * BLOCK> x;
+        for (size_t i = 0; i < BLOCK; i++) {
+            x[i] = w[i];
+            x[BLOCK + i] = (w[i] >> 32u) | (i + 1 < BLOCK ? w[i + 1] << 32u : 0);
+        }
+        unsigned have = 1;
+        for (; 2 * have <= len; have *= 2) {
+            for (auto& v : x) {
+                v &= v >> have;
+            }
+        }
+        if (have < len) {
+            for (auto& v : x) {
+                v &= v >> (len - have);
+            }
+        }
+        uint64_t any = 0;
+        for (auto v : x) {
+            any |= v;
+        }
+        if (any) {
+            for (size_t i = 0; i < BLOCK; i++) {
+                scanner.feed(w[i]);
+            }
+        } else {
+            scanner.skip(w[0], w[BLOCK - 1], BLOCK);
+        }
+    }
+    uint64_t done = 64 * BLOCK * full_blocks;
+    if (done == n) {
+        return scanner.summary();
+    }
+    return combine(scanner.summary(), summarizeRuns(words + BLOCK * full_blocks, n - done));
+}
+
+// Splits the stream into word-aligned chunks, one per thread, and joins
+// their summaries.
+uint64_t longestRun(const std::vector<uint64_t>& words, uint64_t n,
+                    size_t num_threads = std::thread::hardware_concurrency()) {
+    uint64_t num_words = (n + 63) / 64;
+    num_threads = std::clamp<uint64_t>(num_threads, 1, std::max<uint64_t>(num_words, 1));
+    std::vector<RunSummary> summaries(num_threads);
+    std::vector<std::thread> workers;
+    for (size_t t = 0; t < num_threads; t++) {
+        uint64_t low = num_words * t / num_threads;
+        uint64_t high = num_words * (t + 1) / num_threads;
+        uint64_t bits = std::min(n, 64 * high) - 64 * low;
+        workers.emplace_back([&words, &summaries, t, low, bits] {
+            summaries[t] = summarizeRunsBlocked(words.data() + low, bits);
+        });
+    }
+    for (auto& w : workers) {
+        w.join();
+    }
+    for (size_t step = 1; step < num_threads; step *= 2) {
+        for (size_t i = 0; i + step < num_threads; i += 2 * step) {
+            summaries[i] = combine(summaries[i], summaries[i + step]);
+        }
+    }
+    return summaries[0].best;
+}
+
+uint64_t longestRunBitByBit(const std::vector<uint64_t>& words, uint64_t n) {
+    uint64_t longest_streak = 0;
+    uint64_t current_streak = 0;
+    for (uint64_t i = 0; i < n; i++) {
+        if ((words[i / 64] >> (i % 64)) & 1u) {
+            current_streak++;
+        } else {
+            longest_streak = std::max(longest_streak, current_streak);
+            current_streak = 0;
+        }
+    }
+    return std::max(longest_streak, current_streak);
+}
 
 int main() {
     constexpr size_t N = 100;
-    constexpr size_t trials = 1000;
-    std::bernoulli_distribution coin(0.5);
-    size_t longest_streak_count = 0;
-    for (size_t t = 0; t < trials; t++) {
-        size_t longest_streak = 0;
-        size_t current_streak = 0;
-        for (size_t i = 0; i < N; i++) {
-            if (coin(gen)) {
-                current_streak++;
-            } else {
-                longest_streak = std::max(longest_streak, current_streak);
-                current_streak = 0;
+    constexpr size_t trials = 100'000;
+    MonteCarloOptions options {std::random_device{}()};
+    auto stats = runTrials(trials, [](Philox& gen) {
+        std::array<uint64_t, (N + 63) / 64> flips;
+        for (auto& word : flips) {
+            word = gen();
+        }
+        return static_cast<double>(summarizeRuns(flips.data(), N).best);
+    }, options);
+    auto [low, high] = stats.confidenceInterval();
+
+    std::cout << "Expected number of longest streak : " << stats.mean << '\n';
+    std::cout << "95% confidence interval : [" << low << ", " << high << "] (seed " << options.seed << ")\n";
+    std::cout << "ln N : " << std::log(N) << '\n';
+    auto exact = longestRunDistribution(N);
+    std::cout << "Exact : " << mean(exact) << ", most likely " << std::max_element(exact.begin(), exact.end()) - exact.begin()
+              << ", P(longest streak >= 10) = " << 1.0 - std::accumulate(exact.begin(), exact.begin() + 10, 0.0) << '\n';
+    assert(std::abs(stats.mean - mean(exact)) < 5 * stats.standardError());
+
+    Xoshiro256pp gen(options.seed);
+    for (size_t i = 0; i < 2000; i++) {
+        uint64_t n = uniformBelow(gen, 64 * 40);
+        std::vector<uint64_t> words((n + 63) / 64 + 1);
+        // Denser streams for later i, so that long and all-ones runs show up.
+        for (auto& word : words) {
+            word = ~uint64_t{0};
+            for (size_t k = 0; k < i % 7; k++) {
+                word &= gen() | gen() | gen();
             }
         }
-        longest_streak = std::max(longest_streak, current_streak);
-        longest_streak_count += longest_streak;
+        uint64_t expected = longestRunBitByBit(words, n);
+        assert(summarizeRuns(words.data(), n).best == expected);
+        assert(summarizeRunsBlocked(words.data(), n).best == expected);
+        assert(longestRun(words, n, 1 + i % 5) == expected);
     }
 
-    std::cout << "Expected number of longest streak : " << static_cast<double>(longest_streak_count) /
-            static_cast<double>(trials) << '\n';
-    std::cout << "ln N : " << std::log(N);
+    constexpr uint64_t BITS = uint64_t{1} << 32u;
+    std::vector<uint64_t> stream(BITS / 64);
+    Xoshiro256x8 bulk(options.seed);
+    bulk.fill(stream.data(), stream.size());
+    auto t1 = std::chrono::steady_clock::now();
+    uint64_t by_word = summarizeRuns(stream.data(), BITS).best;
+    auto t2 = std::chrono::steady_clock::now();
+    uint64_t by_block = summarizeRunsBlocked(stream.data(), BITS).best;
+    auto t3 = std::chrono::steady_clock::now();
+    uint64_t parallel = longestRun(stream, BITS);
+    auto t4 = std::chrono::steady_clock::now();
+    assert(by_word == by_block && by_block == parallel);
+    auto ms = [](auto d) { return std::chrono::duration_cast<std::chrono::milliseconds>(d).count(); };
+    std::cout << "Longest run in 2^32 fair bits : " << parallel << " (log2 n = 32)\n";
+    std::cout << "By word : " << ms(t2 - t1) << "ms, by block : " << ms(t3 - t2) << "ms, parallel : "
+              << ms(t4 - t3) << "ms\n";
 
 }
\ No newline at end of file
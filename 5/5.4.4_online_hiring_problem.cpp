@@ -1,36 +1,137 @@
 #include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <cmath>
 #include <iostream>
 #include <numeric>
 #include <random>
+#include <thread>
 #include <utility>
 #include <vector>
 
+#include "shuffle.h"
+
 std::mt19937 gen(std::random_device{}());
 
-int main() {
-    constexpr size_t N = 100;
-    constexpr size_t trials = 10000;
-    std::vector<size_t> v (N);
-    std::iota(v.begin(), v.end(), 1);
+// Adds to scores[K] the score of the candidate hired when the first K are
+// only interviewed, for every K in [1, n) at once. With threshold
+// max(u[0, K)), the first later candidate to beat it beats everyone before
+// them too, so it is the first left-to-right maximum at a position >= K. A
+// backward scan therefore hands every K its score in O(n). hired_best[K]
+// counts the times that candidate is the best one, n. is_record is scratch
+// space owned by the caller, so repeated calls do not allocate.
+void addScores(const std::vector<size_t>& u, std::vector<bool>& is_record, std::vector<uint64_t>& scores,
+               std::vector<uint64_t>& hired_best) {
+    const size_t n = u.size();
+    is_record.resize(n);
+    size_t best_score = 0;
+    for (size_t i = 0; i < n; i++) {
+        is_record[i] = u[i] > best_score;
+        best_score = std::max(best_score, u[i]);
+    }
+    size_t next_record_score = 0;
+    for (size_t K = n; K-- > 1;) {
+        if (is_record[K]) {
+            next_record_score = u[K];
+        }
+        scores[K] += next_record_score;
+        hired_best[K] += next_record_score == n;
+    }
+}
 
-    for (size_t K = 1; K < N; K++) {
-        size_t total_best_score = 0;
-        for (size_t t = 0; t < trials; t++) {
-            auto u = v;
-            std::shuffle(u.begin(), u.end(), gen);
+struct HiringCurve {
+    std::vector<double> average_score;
+    std::vector<double> best_probability;
+};
+
+// Average score and probability of hiring the best for every K over the
+// given number of random orders of the candidates 1..n. Trials run in
+// blocks, block b drawing from Philox stream b of the seed, and scores are
+// summed as integers, so the curve depends only on the seed.
+HiringCurve hiringCurve(size_t n, uint64_t trials, uint64_t seed,
+                        size_t num_threads = std::thread::hardware_concurrency()) {
+    constexpr uint64_t BLOCK = 1024;
+    const uint64_t num_blocks = (trials + BLOCK - 1) / BLOCK;
+    num_threads = std::clamp<uint64_t>(num_threads, 1, std::max<uint64_t>(num_blocks, 1));
+    std::vector<std::vector<uint64_t>> totals(num_threads, std::vector<uint64_t>(n));
+    std::vector<std::vector<uint64_t>> best_counts(num_threads, std::vector<uint64_t>(n));
+    std::atomic<uint64_t> next_block {0};
+
+    auto worker = [&](size_t t) {
+        std::vector<size_t> u(n);
+        std::vector<bool> is_record(n);
+        for (uint64_t b = next_block++; b < num_blocks; b = next_block++) {
+            Philox philox(seed, b);
+            Xoshiro256pp block_gen(philox());
+            for (uint64_t i = b * BLOCK; i < std::min(trials, (b + 1) * BLOCK); i++) {
+                std::iota(u.begin(), u.end(), 1);
+                fisherYates(u.data(), n, block_gen);
+                addScores(u, is_record, totals[t], best_counts[t]);
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < num_threads; t++) {
+        workers.emplace_back(worker, t);
+    }
+    worker(0);
+    for (auto& w : workers) {
+        w.join();
+    }
+
+    HiringCurve res {std::vector<double>(n), std::vector<double>(n)};
+    for (size_t K = 1; K < n; K++) {
+        uint64_t total = 0, best_count = 0;
+        for (size_t t = 0; t < num_threads; t++) {
+            total += totals[t][K];
+            best_count += best_counts[t][K];
+        }
+        res.average_score[K] = static_cast<double>(total) / static_cast<double>(trials);
+        res.best_probability[K] = static_cast<double>(best_count) / static_cast<double>(trials);
+    }
+    return res;
+}
+
+int main() {
+    std::vector<bool> is_record;
+    for (size_t t = 0; t < 1000; t++) {
+        std::vector<size_t> u(t % 32);
+        std::iota(u.begin(), u.end(), 1);
+        std::shuffle(u.begin(), u.end(), gen);
+        std::vector<uint64_t> scores(u.size()), hired_best(u.size());
+        addScores(u, is_record, scores, hired_best);
+        for (size_t K = 1; K < u.size(); K++) {
             size_t best_score = 0;
             for (size_t i = 0; i < K; i++) {
                 best_score = std::max(best_score, u[i]);
             }
-            for (size_t i = K; i < N; i++) {
+            size_t score = 0;
+            for (size_t i = K; i < u.size(); i++) {
                 if (u[i] > best_score) {
-                    total_best_score += u[i];
+                    score = u[i];
                     break;
                 }
             }
+            assert(scores[K] == score);
+            assert(hired_best[K] == (score == u.size()));
         }
-        std::cout << "Average best score with K " << K << " and N " << N << " : "
-                  << static_cast<double>(total_best_score) / static_cast<double>(trials) << '\n';
     }
+
+    constexpr size_t N = 100;
+    constexpr size_t trials = 1'000'000;
+    uint64_t seed = std::random_device{}();
+    auto curve = hiringCurve(N, trials, seed);
+    auto small = hiringCurve(N, 5000, seed, 1);
+    auto small_threaded = hiringCurve(N, 5000, seed, 3);
+    assert(small.average_score == small_threaded.average_score);
+    assert(small.best_probability == small_threaded.best_probability);
+    assert(hiringCurve(0, 5000, seed).average_score.empty());
+    for (size_t K = 1; K < N; K++) {
+        std::cout << "Average best score with K " << K << " and N " << N << " : " << curve.average_score[K]
+                  << ", probability of hiring the best : " << curve.best_probability[K] << '\n';
+    }
+    auto& p = curve.best_probability;
+    auto best_K = std::max_element(p.begin() + 1, p.end()) - p.begin();
+    std::cout << "K hiring the best most often : " << best_K << " (seed " << seed << "), N / e : "
+              << N / std::exp(1.0) << '\n';
 }
\ No newline at end of file
@@ -0,0 +1,317 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "rng.h"
+
+// Samples outcome i of [0, n) with probability proportional to weights[i] in
+// O(1) by Walker's alias method: column i keeps its own outcome with
+// probability threshold / 2^32 and gives the rest to its alias, and one
+// random word picks both the column (high half of word * n) and the coin
+// (the low half). Masses are scaled to integers summing to exactly n * 2^32.
+// The build is Vose's method with both worklists swept in index order
+// (Huebschle-Schneider and Sanders, "Parallel weighted random sampling"):
+// who pays whose deficit follows from prefix sums, so fixed blocks are built
+// in parallel and the table does not depend on the thread count.
+//
+// update() changes a weight without a rebuild. A lower weight is corrected
+// by rejection against the weight the table was built with, a higher one
+// puts its excess on a short overflow list drawn from directly, and the
+// table is rebuilt once that list gets long or acceptance drops too low.
+struct AliasTable {
+    struct Column {
+        uint32_t threshold;
+        uint32_t alias;
+    };
+
+    std::vector<Column> columns;
+    std::vector<double> weights;
+    // What the table was built from.
+    std::vector<double> bounds;
+    std::vector<uint32_t> overflow;
+    double bounds_total = 0.0;
+    // Sum of min(weights, bounds) and of the excess of weights over bounds.
+    double kept_total = 0.0;
+    double excess_total = 0.0;
+    // Weights below their bound; while there are none, kept_total is
+    // bounds_total exactly rather than a sum that has drifted.
+    size_t lowered = 0;
+    size_t num_threads;
+    size_t max_overflow = 64;
+    double min_acceptance = 0.5;
+    size_t rebuilds = 0;
+
+    explicit AliasTable(std::vector<double> w, size_t num_threads = std::thread::hardware_concurrency())
+            : weights {std::move(w)}, num_threads {std::max<size_t>(num_threads, 1)} {
+        assert(!weights.empty() && weights.size() <= (size_t{1} << 31u));
+        rebuild();
+    }
+
+    size_t size() const {
+        return weights.size();
+    }
+
+    // True while every draw comes straight from the table.
+    bool exact() const {
+        return lowered == 0 && overflow.empty();
+    }
+
+    // Current probability of outcome i.
+    double probability(size_t i) const {
+        return weights[i] / (kept_total + excess_total);
+    }
+
+    uint32_t pick(uint64_t word) const {
+        auto m = static_cast<unsigned __int128>(word) * columns.size();
+        auto i = static_cast<uint32_t>(m >> 64u);
+        auto coin = static_cast<uint32_t>(static_cast<uint64_t>(m) >> 32u);
+        return coin < columns[i].threshold ? i : columns[i].alias;
+    }
+
+    template <typename Gen>
+    uint32_t operator()(Gen& gen) const {
+        return exact() ? pick(gen()) : pickUpdated(gen);
+    }
+
+    // Fills out[0, count) with draws, a block of raw words at a time from the
+    // lane-parallel generator.
+    void operator()(Xoshiro256x8& gen, uint32_t* out, size_t count) const {
+        constexpr size_t BLOCK = 256;
+        alignas(64) std::array<uint64_t, BLOCK> words;
+        if (!exact()) {
+            size_t next = BLOCK;
+            auto word = [&] {
+                if (next == BLOCK) {
+                    gen.fill(words.data(), BLOCK);
+                    next = 0;
+                }
+                return words[next++];
+            };
+            for (size_t i = 0; i < count; i++) {
+                out[i] = pickUpdated(word);
+            }
+            return;
+        }
+        for (size_t begin = 0; begin < count; begin += BLOCK) {
+            size_t size = std::min(count - begin, BLOCK);
+            gen.fill(words.data(), size);
+            for (size_t i = 0; i < size; i++) {
+                out[begin + i] = pick(words[i]);
+            }
+        }
+    }
+
+    void update(size_t i, double weight) {
+        assert(weight >= 0.0);
+        double bound = bounds[i], old = weights[i];
+        bool was_over = old > bound, is_over = weight > bound;
+        kept_total += std::min(weight, bound) - std::min(old, bound);
+        excess_total += std::max(weight - bound, 0.0) - std::max(old - bound, 0.0);
+        weights[i] = weight;
+        lowered += weight < bound;
+        lowered -= old < bound;
+        if (lowered == 0) {
+            kept_total = bounds_total;
+        }
+        if (is_over && !was_over) {
+            overflow.push_back(static_cast<uint32_t>(i));
+        } else if (was_over && !is_over) {
+            auto it = std::find(overflow.begin(), overflow.end(), static_cast<uint32_t>(i));
+            *it = overflow.back();
+            overflow.pop_back();
+        }
+        if (overflow.empty()) {
+            excess_total = 0.0;
+        }
+        if (overflow.size() > max_overflow
+                || kept_total + excess_total < min_acceptance * (bounds_total + excess_total)) {
+            // Some weight has to stay positive for there to be anything to draw.
+            assert(kept_total + excess_total > 0.0);
+            rebuild();
+        }
+    }
+
+    void rebuild() {
+        bounds = weights;
+        overflow.clear();
+        excess_total = 0.0;
+        lowered = 0;
+        build();
+        kept_total = bounds_total;
+        rebuilds++;
+    }
+
+private:
+    static constexpr size_t GRAIN = size_t{1} << 14u;
+    static constexpr uint64_t ONE = uint64_t{1} << 32u;
+
+    // Draws against the current weights: the overflow list with probability
+    // excess_total / (bounds_total + excess_total), otherwise a table draw
+    // that survives with probability min(weight, bound) / bound.
+    template <typename Gen>
+    uint32_t pickUpdated(Gen& gen) const {
+        while (true) {
+            double u = uniformDouble(gen) * (bounds_total + excess_total);
+            if (u < excess_total) {
+                for (auto i : overflow) {
+                    u -= weights[i] - bounds[i];
+                    if (u < 0.0) {
+                        return i;
+                    }
+                }
+                return overflow.back();
+            }
+            uint32_t i = pick(gen());
+            if (weights[i] >= bounds[i] || uniformDouble(gen) * bounds[i] < weights[i]) {
+                return i;
+            }
+        }
+    }
+
+    // Runs f(b, low, high) on every block b = [low, high) of GRAIN items of
+    // [0, n), blocks handed out to the threads as they come free.
+    template <typename F>
+    void forEachBlock(size_t n, F f) const {
+        const size_t num_blocks = (n + GRAIN - 1) / GRAIN;
+        std::atomic<size_t> next_block {0};
+        auto worker = [&] {
+            for (size_t b = next_block++; b < num_blocks; b = next_block++) {
+                f(b, b * GRAIN, std::min(n, (b + 1) * GRAIN));
+            }
+        };
+        std::vector<std::thread> workers;
+        for (size_t t = 1; t < std::min(num_threads, num_blocks); t++) {
+            workers.emplace_back(worker);
+        }
+        worker();
+        for (auto& w : workers) {
+            w.join();
+        }
+    }
+
+    void build() {
+        const size_t n = bounds.size();
+        const size_t num_blocks = (n + GRAIN - 1) / GRAIN;
+        columns.resize(n);
+
+        // Block sums are added in block order, so the total does not depend on the thread count.
+        std::vector<double> block_total(num_blocks);
+        forEachBlock(n, [&](size_t b, size_t low, size_t high) {
+            for (size_t i = low; i < high; i++) {
+                block_total[b] += bounds[i];
+            }
+        });
+        bounds_total = 0.0;
+        for (auto s : block_total) {
+            bounds_total += s;
+        }
+        assert(bounds_total > 0.0);
+
+        // Integer masses, with the rounding error put on the heaviest outcome.
+        const double scale = static_cast<double>(n) * static_cast<double>(ONE) / bounds_total;
+        std::vector<uint64_t> mass(n), block_mass(num_blocks);
+        std::vector<size_t> block_heaviest(num_blocks);
+        forEachBlock(n, [&](size_t b, size_t low, size_t high) {
+            size_t heaviest = low;
+            for (size_t i = low; i < high; i++) {
+                mass[i] = static_cast<uint64_t>(bounds[i] * scale);
+                block_mass[b] += mass[i];
+                heaviest = mass[i] > mass[heaviest] ? i : heaviest;
+            }
+            block_heaviest[b] = heaviest;
+        });
+        uint64_t total_mass = 0;
+        size_t heaviest = 0;
+        for (size_t b = 0; b < num_blocks; b++) {
+            total_mass += block_mass[b];
+            heaviest = mass[block_heaviest[b]] > mass[heaviest] ? block_heaviest[b] : heaviest;
+        }
+        mass[heaviest] += n * ONE - total_mass;
+
+        // Light and heavy counts per block, then their offsets and the
+        // deficit and excess prefix sums where every block starts.
+        std::vector<size_t> light_offset(num_blocks + 1), heavy_offset(num_blocks + 1);
+        std::vector<uint64_t> deficit_offset(num_blocks + 1), excess_offset(num_blocks + 1);
+        forEachBlock(n, [&](size_t b, size_t low, size_t high) {
+            for (size_t i = low; i < high; i++) {
+                if (mass[i] < ONE) {
+                    light_offset[b + 1]++;
+                    deficit_offset[b + 1] += ONE - mass[i];
+                } else if (mass[i] > ONE) {
+                    heavy_offset[b + 1]++;
+                    excess_offset[b + 1] += mass[i] - ONE;
+                }
+            }
+        });
+        for (size_t b = 0; b < num_blocks; b++) {
+            light_offset[b + 1] += light_offset[b];
+            heavy_offset[b + 1] += heavy_offset[b];
+            deficit_offset[b + 1] += deficit_offset[b];
+            excess_offset[b + 1] += excess_offset[b];
+        }
+        assert(deficit_offset[num_blocks] == excess_offset[num_blocks]);
+
+        const size_t num_lights = light_offset[num_blocks], num_heavies = heavy_offset[num_blocks];
+        std::vector<uint32_t> lights(num_lights), heavies(num_heavies);
+        // Where each light's deficit and each heavy's excess start on the common line.
+        std::vector<uint64_t> light_start(num_lights), heavy_start(num_heavies);
+        forEachBlock(n, [&](size_t b, size_t low, size_t high) {
+            size_t l = light_offset[b], h = heavy_offset[b];
+            uint64_t deficit = deficit_offset[b], excess = excess_offset[b];
+            for (size_t i = low; i < high; i++) {
+                if (mass[i] < ONE) {
+                    lights[l] = static_cast<uint32_t>(i);
+                    light_start[l++] = deficit;
+                    deficit += ONE - mass[i];
+                } else if (mass[i] > ONE) {
+                    heavies[h] = static_cast<uint32_t>(i);
+                    heavy_start[h++] = excess;
+                    excess += mass[i] - ONE;
+                }
+                // Full columns, and heavies until they are known to run out.
+                columns[i] = {std::numeric_limits<uint32_t>::max(), static_cast<uint32_t>(i)};
+            }
+        });
+
+        // Every light takes its deficit from the heavy whose interval it starts in.
+        forEachBlock(num_lights, [&](size_t, size_t low, size_t high) {
+            size_t h = std::upper_bound(heavy_start.begin(), heavy_start.end(), light_start[low])
+                       - heavy_start.begin() - 1;
+            for (size_t l = low; l < high; l++) {
+                while (h + 1 < num_heavies && heavy_start[h + 1] <= light_start[l]) {
+                    h++;
+                }
+                columns[lights[l]] = {static_cast<uint32_t>(mass[lights[l]]), heavies[h]};
+            }
+        });
+
+        // A heavy whose interval ends inside a light's deficit has given away
+        // more than its excess; the next heavy makes up the difference.
+        forEachBlock(num_heavies, [&](size_t, size_t low, size_t high) {
+            if (num_lights == 0) {
+                return;
+            }
+            size_t l = std::upper_bound(light_start.begin(), light_start.end(), heavy_start[low])
+                       - light_start.begin();
+            for (size_t h = low; h + 1 < std::min(high + 1, num_heavies); h++) {
+                uint64_t end = heavy_start[h + 1];
+                while (l < num_lights && light_start[l] <= end) {
+                    l++;
+                }
+                // Light l - 1 is the last to start at or before the end.
+                uint64_t light_end = light_start[l - 1] + (ONE - mass[lights[l - 1]]);
+                if (light_start[l - 1] < end && end < light_end) {
+                    columns[heavies[h]] = {static_cast<uint32_t>(ONE - (light_end - end)), heavies[h + 1]};
+                }
+            }
+        });
+    }
+};
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cstdint>
+#include <vector>
+
+// Counts keys from [0, domain) between resets without allocating or clearing
+// anything per round. Every counter carries the epoch it was last written in
+// and counts from older epochs read as zero, so reset() is O(1). A small
+// domain gets one counter per key; a large one gets an open-addressing table
+// sized for max_keys keys per round.
+struct CollisionDetector {
+    struct Slot {
+        uint64_t key;
+        uint32_t epoch;
+        uint32_t count;
+    };
+
+    std::vector<Slot> slots;
+    size_t max_keys;
+    bool direct;
+    unsigned shift = 0;
+    uint32_t epoch = 1;
+    // Distinct keys counted since the last reset.
+    size_t num_keys = 0;
+
+    CollisionDetector(uint64_t domain, size_t max_keys)
+            : max_keys {std::max<size_t>(max_keys, 1)}, direct {domain <= 64 * this->max_keys} {
+        if (direct) {
+            slots.assign(domain, Slot {0, 0, 0});
+        } else {
+            size_t capacity = std::bit_ceil(2 * this->max_keys);
+            shift = 64 - std::countr_zero(capacity);
+            slots.assign(capacity, Slot {0, 0, 0});
+        }
+    }
+
+    void reset() {
+        num_keys = 0;
+        if (++epoch == 0) {
+            for (auto& slot : slots) {
+                slot.epoch = 0;
+            }
+            epoch = 1;
+        }
+    }
+
+    // Counts one more occurrence of key and returns how many there are now.
+    uint32_t add(uint64_t key) {
+        Slot* slot;
+        if (direct) {
+            slot = &slots[key];
+        } else {
+            size_t mask = slots.size() - 1;
+            size_t i = static_cast<size_t>((key * 0x9E3779B97F4A7C15u) >> shift);
+            while (slots[i].epoch == epoch && slots[i].key != key) {
+                i = (i + 1) & mask;
+            }
+            slot = &slots[i];
+        }
+        if (slot->epoch != epoch) {
+            // The table is sized for max_keys keys and the probe only ends
+            // at a free slot, so more than that per round is a caller bug.
+            assert(num_keys < max_keys);
+            num_keys++;
+            *slot = {key, epoch, 0};
+        }
+        return ++slot->count;
+    }
+};
+
+// Starts a new round and draws n keys with next(), stopping early once some
+// key has come up k times. Returns whether that happened.
+template <typename Next>
+bool hasCollision(CollisionDetector& detector, size_t n, uint32_t k, Next next) {
+    detector.reset();
+    for (size_t i = 0; i < n; i++) {
+        if (detector.add(next()) >= k) {
+            return true;
+        }
+    }
+    return false;
+}
\ No newline at end of file
@@ -0,0 +1,132 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+// Exact distributions for the chapter 5 simulations, by dynamic programming
+// over Markov chains whose states carry probabilities rather than counts, so
+// nothing overflows and plain doubles are enough. Each runs in milliseconds
+// for the sizes the programs simulate and serves as their reference.
+
+// Probability that no day gets k or more of the people when each picks one
+// of the days at random. a[m] holds m! [x^m] G(x)^t for the first t days,
+// with G(x) = sum_{j<k} (x / days)^j / j!; adding a day maps a[m] to
+// sum_{j<k} C(m, j) days^-j a[m - j], and a[people] is the answer after all
+// days. O(days * people * k).
+inline double noKCollisionProbability(size_t people, size_t days, size_t k) {
+    std::vector<double> a(people + 1), next(people + 1);
+    a[0] = 1.0;
+    for (size_t t = 0; t < days; t++) {
+        for (size_t m = 0; m <= people; m++) {
+            double term = 1.0; // C(m, j) days^-j
+            double sum = 0.0;
+            for (size_t j = 0; j < k && j <= m; j++) {
+                sum += term * a[m - j];
+                term *= static_cast<double>(m - j) / static_cast<double>((j + 1) * days);
+            }
+            next[m] = sum;
+        }
+        a.swap(next);
+    }
+    return a[people];
+}
+
+// Distribution of the longest run of ones in n flips that come up one with
+// probability p; entry r is P(longest run = r), up to where the rest is
+// below tail. With A(i) the chance that the first i flips hold no run of r
+// ones, A(i) = A(i - 1) - p^r (1 - p) A(i - r - 1), since the first such run
+// ends at i exactly when flips i - r + 1..i are ones, flip i - r is not and
+// nothing before it qualifies. O(n) per r.
+inline std::vector<double> longestRunDistribution(size_t n, double p = 0.5, double tail = 1e-15) {
+    std::vector<double> no_run_below {0.0}; // P(longest run < r), for r = 0, 1, ...
+    std::vector<double> A(n + 1);
+    for (size_t r = 1; r <= n; r++) {
+        double p_r = std::pow(p, static_cast<double>(r));
+        for (size_t i = 0; i <= n; i++) {
+            if (i < r) {
+                A[i] = 1.0;
+            } else if (i == r) {
+                A[i] = 1.0 - p_r;
+            } else {
+                A[i] = A[i - 1] - p_r * (1.0 - p) * A[i - r - 1];
+            }
+        }
+        no_run_below.push_back(A[n]);
+        if (1.0 - A[n] < tail) {
+            break;
+        }
+    }
+    if (no_run_below.size() == n + 1) {
+        no_run_below.push_back(1.0);
+    }
+    std::vector<double> res(no_run_below.size() - 1);
+    for (size_t r = 0; r < res.size(); r++) {
+        res[r] = no_run_below[r + 1] - no_run_below[r];
+    }
+    return res;
+}
+
+// Distribution of the number of occupied bins after tossing balls into bins
+// at random; a toss fills a new bin with probability (bins - j) / bins when
+// j are occupied. O(balls * bins).
+inline std::vector<double> occupiedBinsDistribution(size_t balls, size_t bins) {
+    std::vector<double> occupied(bins + 1);
+    occupied[0] = 1.0;
+    for (size_t b = 0; b < balls; b++) {
+        for (size_t j = std::min(b + 1, bins); j > 0; j--) {
+            double fresh = static_cast<double>(bins - j + 1) / static_cast<double>(bins);
+            occupied[j] = occupied[j] * static_cast<double>(j) / static_cast<double>(bins) + occupied[j - 1] * fresh;
+        }
+        occupied[0] = 0.0;
+    }
+    return occupied;
+}
+
+// Distribution of the number of tosses until every one of bins bins holds a
+// ball; entry t is P(T = t), up to where the mass still short of full is
+// below tail. This runs the occupancy chain above and reads off the mass
+// that reaches all bins at each step.
+inline std::vector<double> couponCollectorDistribution(size_t bins, double tail = 1e-15) {
+    if (bins == 0) {
+        return {1.0};
+    }
+    std::vector<double> occupied(bins + 1), res {0.0};
+    occupied[0] = 1.0;
+    double live = 1.0;
+    for (size_t t = 1; live >= tail && live > 0.0; t++) {
+        double full = occupied[bins - 1] / static_cast<double>(bins);
+        for (size_t j = std::min(t, bins - 1); j > 0; j--) {
+            double fresh = static_cast<double>(bins - j + 1) / static_cast<double>(bins);
+            occupied[j] = occupied[j] * static_cast<double>(j) / static_cast<double>(bins) + occupied[j - 1] * fresh;
+        }
+        occupied[0] = 0.0;
+        res.push_back(full);
+        live = 0.0;
+        for (size_t j = 0; j < bins; j++) {
+            live += occupied[j];
+        }
+    }
+    return res;
+}
+
+inline double mean(const std::vector<double>& distribution) {
+    double res = 0.0;
+    for (size_t i = 0; i < distribution.size(); i++) {
+        res += static_cast<double>(i) * distribution[i];
+    }
+    return res;
+}
+
+// Smallest value whose cumulative probability reaches q.
+inline size_t quantile(const std::vector<double>& distribution, double q) {
+    double cumulative = 0.0;
+    for (size_t i = 0; i < distribution.size(); i++) {
+        cumulative += distribution[i];
+        if (cumulative >= q) {
+            return i;
+        }
+    }
+    return distribution.size() - 1;
+}
\ No newline at end of file
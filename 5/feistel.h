@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+
+#include "rng.h"
+
+// Keyed pseudo-random permutation of [0, n) that maps an index to its image
+// and back in O(1) time and memory, so permutations of more IDs than fit in
+// memory can be walked in any order. A balanced Feistel network scrambles
+// the smallest domain of 4^k >= n values, and cycle walking (Black and
+// Rogaway, "Ciphers with arbitrary finite domains") reapplies it until the
+// value lands back in [0, n), under four times on average. Halves are at
+// most 32 bits, so the round function is 32-bit multiply-xorshift and the
+// batch calls below vectorize. Rounds add modulo 2^k instead of xoring: on
+// tiny domains xor rounds only reach a subgroup of the permutations and
+// the orders never become uniform, however many rounds are run.
+struct FeistelPermutation {
+    static constexpr size_t ROUNDS = 12;
+
+    uint64_t n;
+    unsigned half_bits;
+    uint32_t mask;
+    std::array<uint32_t, ROUNDS> keys;
+
+    FeistelPermutation(uint64_t n, uint64_t seed)
+            : n {n}, half_bits {std::max(1u, (static_cast<unsigned>(std::bit_width(n - 1)) + 1) / 2)},
+              mask {static_cast<uint32_t>((uint64_t{1} << half_bits) - 1)} {
+        assert(n > 0);
+        for (auto& key : keys) {
+            key = static_cast<uint32_t>(splitMix64(seed));
+        }
+    }
+
+    static uint32_t mix(uint32_t x) {
+        x ^= x >> 16u;
+        x *= 0x7FEB352Du;
+        x ^= x >> 15u;
+        x *= 0x846CA68Bu;
+        return x ^ (x >> 16u);
+    }
+
+    uint64_t encrypt(uint64_t x) const {
+        auto left = static_cast<uint32_t>(x >> half_bits), right = static_cast<uint32_t>(x) & mask;
+        for (size_t r = 0; r < ROUNDS; r++) {
+            left = (left + mix(right ^ keys[r])) & mask;
+            std::swap(left, right);
+        }
+        return static_cast<uint64_t>(left) << half_bits | right;
+    }
+
+    uint64_t decrypt(uint64_t x) const {
+        auto left = static_cast<uint32_t>(x >> half_bits), right = static_cast<uint32_t>(x) & mask;
+        for (size_t r = ROUNDS; r-- > 0;) {
+            std::swap(left, right);
+            left = (left - mix(right ^ keys[r])) & mask;
+        }
+        return static_cast<uint64_t>(left) << half_bits | right;
+    }
+
+    // Image of i < n.
+    uint64_t operator()(uint64_t i) const {
+        assert(i < n);
+        do {
+            i = encrypt(i);
+        } while (i >= n);
+        return i;
+    }
+
+    // Index whose image is j < n.
+    uint64_t inverse(uint64_t j) const {
+        assert(j < n);
+        do {
+            j = decrypt(j);
+        } while (j >= n);
+        return j;
+    }
+
+    // Batch versions: out[i] = image (or preimage) of in[i] for i < count.
+    void operator()(const uint64_t* in, uint64_t* out, size_t count) const {
+        transform<false>(in, out, count);
+    }
+
+    void inverse(const uint64_t* in, uint64_t* out, size_t count) const {
+        transform<true>(in, out, count);
+    }
+
+private:
+    static constexpr size_t BLOCK = 256;
+
+    // One pass of the network over a block, round by round across all
+    // values, with the halves in separate arrays so every round is a
+    // straight-line loop over 32-bit lanes.
+    template <bool INVERSE>
+    void passBlock(uint64_t* values, size_t count) const {
+        alignas(64) std::array<uint32_t, BLOCK> left, right;
+        for (size_t i = 0; i < count; i++) {
+            left[i] = static_cast<uint32_t>(values[i] >> half_bits);
+            right[i] = static_cast<uint32_t>(values[i]) & mask;
+        }
+        for (size_t r = 0; r < ROUNDS; r++) {
+            uint32_t key = keys[INVERSE ? ROUNDS - 1 - r : r];
+            // Forward rounds update the left half and swap; inverse rounds
+            // swap first, so both just alternate which array is updated.
+            auto& dst = (r % 2 == 0) == !INVERSE ? left : right;
+            const auto& src = (r % 2 == 0) == !INVERSE ? right : left;
+            for (size_t i = 0; i < count; i++) {
+                uint32_t f = mix(src[i] ^ key);
+                dst[i] = (INVERSE ? dst[i] - f : dst[i] + f) & mask;
+            }
+        }
+        // An even number of rounds leaves the halves where they started.
+        static_assert(ROUNDS % 2 == 0);
+        for (size_t i = 0; i < count; i++) {
+            values[i] = static_cast<uint64_t>(left[i]) << half_bits | right[i];
+        }
+    }
+
+    // Values that fall outside [0, n) are compacted and walked again
+    // together until none are left.
+    template <bool INVERSE>
+    void transform(const uint64_t* in, uint64_t* out, size_t count) const {
+        alignas(64) std::array<uint64_t, BLOCK> values, walking;
+        std::array<uint16_t, BLOCK> pending;
+        for (size_t begin = 0; begin < count; begin += BLOCK) {
+            size_t size = std::min(count - begin, BLOCK);
+            std::copy(in + begin, in + begin + size, values.begin());
+            passBlock<INVERSE>(values.data(), size);
+            size_t num_pending = 0;
+            for (size_t i = 0; i < size; i++) {
+                pending[num_pending] = static_cast<uint16_t>(i);
+                num_pending += values[i] >= n;
+            }
+            while (num_pending) {
+                for (size_t j = 0; j < num_pending; j++) {
+                    walking[j] = values[pending[j]];
+                }
+                passBlock<INVERSE>(walking.data(), num_pending);
+                size_t still_pending = 0;
+                for (size_t j = 0; j < num_pending; j++) {
+                    values[pending[j]] = walking[j];
+                    pending[still_pending] = pending[j];
+                    still_pending += walking[j] >= n;
+                }
+                num_pending = still_pending;
+            }
+            std::copy(values.begin(), values.begin() + size, out + begin);
+        }
+    }
+};
\ No newline at end of file
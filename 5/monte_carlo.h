@@ -0,0 +1,394 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "rng.h"
+
+// Running mean and variance (Welford), mergeable with Chan et al.'s formula.
+struct TrialStats {
+    uint64_t count = 0;
+    double mean = 0.0;
+    double m2 = 0.0;
+
+    void add(double x) {
+        count++;
+        double delta = x - mean;
+        mean += delta / static_cast<double>(count);
+        m2 += delta * (x - mean);
+    }
+
+    void merge(const TrialStats& other) {
+        if (other.count == 0) {
+            return;
+        }
+        uint64_t total = count + other.count;
+        double delta = other.mean - mean;
+        mean += delta * static_cast<double>(other.count) / static_cast<double>(total);
+        m2 += other.m2 + delta * delta * static_cast<double>(count) * static_cast<double>(other.count) /
+                         static_cast<double>(total);
+        count = total;
+    }
+
+    double variance() const {
+        return count > 1 ? m2 / static_cast<double>(count - 1) : 0.0;
+    }
+
+    double standardError() const {
+        return count ? std::sqrt(variance() / static_cast<double>(count)) : 0.0;
+    }
+
+    double halfWidth(double z = 1.96) const {
+        return z * standardError();
+    }
+
+    std::pair<double, double> confidenceInterval(double z = 1.96) const {
+        return {mean - halfWidth(z), mean + halfWidth(z)};
+    }
+};
+
+enum class Sampling {
+    Independent,
+    Antithetic, // trials in pairs, the second seeing 1 - U for every uniform U of the first
+    Stratified, // the first uniform of the i-th of n trials in a block falls in [i / n, (i + 1) / n)
+    Sobol,      // the first 16 uniforms come from a Sobol sequence under a random digital shift
+};
+
+inline const char* toString(Sampling sampling) {
+    switch (sampling) {
+        case Sampling::Antithetic: return "antithetic";
+        case Sampling::Stratified: return "stratified";
+        case Sampling::Sobol: return "Sobol";
+        default: return "independent";
+    }
+}
+
+struct MonteCarloOptions {
+    uint64_t seed = 0;
+    size_t num_threads = std::thread::hardware_concurrency();
+    uint64_t block_size = 4096;
+    // Stop once the z-confidence half-width drops to this value; 0 runs every trial.
+    double target_half_width = 0.0;
+    double z = 1.96;
+    uint64_t min_trials = 10'000;
+    Sampling sampling = Sampling::Independent;
+};
+
+// Runs work(local, b) for every block b in [0, num_blocks) on up to
+// num_threads threads, each with its own copy local of prototype, which may
+// therefore keep scratch state. Finished blocks are passed to enough(b) in
+// block order, whatever order they finish in; once it returns true no more
+// blocks are started and the blocks after b are dropped, so where a run
+// stops does not depend on scheduling. Returns the number of blocks kept.
+template <typename Local, typename Work, typename Enough>
+uint64_t forEachBlock(uint64_t num_blocks, size_t num_threads, const Local& prototype, Work work, Enough enough) {
+    num_threads = std::clamp<uint64_t>(num_threads, 1, std::max<uint64_t>(num_blocks, 1));
+    std::vector<char> finished(num_blocks);
+    std::atomic<uint64_t> next_block {0};
+    std::atomic<bool> done {false};
+    std::mutex progress_mutex;
+    uint64_t kept = 0;
+
+    auto worker = [&] {
+        Local local = prototype;
+        for (uint64_t b = next_block++; b < num_blocks && !done; b = next_block++) {
+            work(local, b);
+            std::lock_guard<std::mutex> lock(progress_mutex);
+            finished[b] = 1;
+            while (!done && kept < num_blocks && finished[kept]) {
+                done = enough(kept++);
+            }
+        }
+    };
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < num_threads; t++) {
+        workers.emplace_back(worker);
+    }
+    worker();
+    for (auto& w : workers) {
+        w.join();
+    }
+    return kept;
+}
+
+// Runs trial(gen) -> double for the given number of trials. Trials are cut
+// into blocks and block b always draws from Philox stream b of the seed, so
+// a run, including where it stops early, is reproducible from the seed
+// whatever the thread count. Every worker gets its own copy of trial.
+template <typename Trial>
+TrialStats runTrials(uint64_t trials, const Trial& trial, const MonteCarloOptions& options = {}) {
+    const uint64_t num_blocks = (trials + options.block_size - 1) / options.block_size;
+    std::vector<TrialStats> block_stats(num_blocks);
+    TrialStats res;
+    forEachBlock(num_blocks, options.num_threads, trial, [&](Trial& local_trial, uint64_t b) {
+        Philox gen(options.seed, b);
+        uint64_t end = std::min(trials, (b + 1) * options.block_size);
+        for (uint64_t t = b * options.block_size; t < end; t++) {
+            block_stats[b].add(local_trial(gen));
+        }
+    }, [&](uint64_t b) {
+        res.merge(block_stats[b]);
+        return options.target_half_width > 0.0 && res.count >= options.min_trials
+               && res.halfWidth(options.z) <= options.target_half_width;
+    });
+    return res;
+}
+
+// Same block and stream layout as runTrials, but keeps every outcome, in
+// trial order, for when the whole distribution is wanted and not just the mean.
+template <typename Trial>
+std::vector<double> sampleTrials(uint64_t trials, const Trial& trial, const MonteCarloOptions& options = {}) {
+    const uint64_t num_blocks = (trials + options.block_size - 1) / options.block_size;
+    std::vector<double> res(trials);
+    forEachBlock(num_blocks, options.num_threads, trial, [&](Trial& local_trial, uint64_t b) {
+        Philox gen(options.seed, b);
+        uint64_t end = std::min(trials, (b + 1) * options.block_size);
+        for (uint64_t t = b * options.block_size; t < end; t++) {
+            res[t] = local_trial(gen);
+        }
+    }, [](uint64_t) { return false; });
+    return res;
+}
+
+// Replays a generator with every word complemented, turning each uniform U
+// into 1 - U; uniformBelow and uniformDouble map it to the mirrored value.
+template <typename Gen>
+struct AntitheticGen {
+    using result_type = uint64_t;
+
+    Gen gen;
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() { return ~gen(); }
+};
+
+// Confines the first word to stratum of strata equal slices of the range.
+template <typename Gen>
+struct StratifiedGen {
+    using result_type = uint64_t;
+
+    Gen& gen;
+    uint64_t stratum;
+    uint64_t strata;
+    bool first = true;
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        if (!first) {
+            return gen();
+        }
+        first = false;
+        return static_cast<uint64_t>(((static_cast<unsigned __int128>(stratum) << 64u) + gen()) / strata);
+    }
+};
+
+// Point index of the Sobol sequence in its first DIMS coordinates, with
+// direction numbers from Joe and Kuo, one coordinate per word drawn; the
+// top 32 bits are the Sobol digits and the rest, like every word past the
+// first DIMS, come from gen. XORing the words with a random shift keeps
+// each one uniform while the points stay evenly spread.
+template <typename Gen>
+struct SobolGen {
+    using result_type = uint64_t;
+    static constexpr size_t DIMS = 16;
+
+    Gen& gen;
+    uint64_t index;
+    const std::array<uint64_t, DIMS>& shift;
+    size_t dim = 0;
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    static const std::array<std::array<uint32_t, 32>, DIMS>& directions() {
+        static const auto table = [] {
+            struct Polynomial {
+                unsigned degree;
+                uint32_t a;
+                std::array<uint32_t, 6> m;
+            };
+            constexpr std::array<Polynomial, DIMS - 1> POLYNOMIALS {{
+                    {1, 0, {1}}, {2, 1, {1, 3}}, {3, 1, {1, 3, 1}}, {3, 2, {1, 1, 1}},
+                    {4, 1, {1, 1, 3, 3}}, {4, 4, {1, 3, 5, 13}}, {5, 2, {1, 1, 5, 5, 17}},
+                    {5, 4, {1, 1, 5, 5, 5}}, {5, 7, {1, 1, 7, 11, 19}}, {5, 11, {1, 1, 5, 1, 1}},
+                    {5, 13, {1, 1, 1, 3, 11}}, {5, 14, {1, 3, 5, 5, 31}}, {6, 1, {1, 3, 3, 9, 7, 49}},
+                    {6, 13, {1, 1, 1, 15, 21, 21}}, {6, 16, {1, 3, 1, 13, 27, 49}},
+            }};
+            std::array<std::array<uint32_t, 32>, DIMS> v {};
+            for (unsigned j = 0; j < 32; j++) {
+                v[0][j] = uint32_t{1} << (31 - j);
+            }
+            for (size_t d = 1; d < DIMS; d++) {
+                const auto& [s, a, m] = POLYNOMIALS[d - 1];
+                for (unsigned j = 0; j < 32; j++) {
+                    if (j < s) {
+                        v[d][j] = m[j] << (31 - j);
+                        continue;
+                    }
+                    v[d][j] = v[d][j - s] ^ (v[d][j - s] >> s);
+                    for (unsigned l = 1; l < s; l++) {
+                        if ((a >> (s - 1 - l)) & 1u) {
+                            v[d][j] ^= v[d][j - l];
+                        }
+                    }
+                }
+            }
+            return v;
+        }();
+        return table;
+    }
+
+    result_type operator()() {
+        if (dim >= DIMS) {
+            return gen();
+        }
+        uint32_t digits = 0;
+        uint64_t gray = index ^ (index >> 1u);
+        for (unsigned j = 0; gray && j < 32; gray >>= 1u, j++) {
+            if (gray & 1u) {
+                digits ^= directions()[dim][j];
+            }
+        }
+        uint64_t res = ((static_cast<uint64_t>(digits) << 32u) | (gen() >> 32u)) ^ shift[dim];
+        dim++;
+        return res;
+    }
+};
+
+struct Estimate {
+    double mean = 0.0;
+    double standard_error = 0.0;
+    uint64_t trials = 0;
+    // Variance of a single trial, what independent sampling would pay per trial.
+    double trial_variance = 0.0;
+    // Independent trials that would give the same standard error.
+    double effective_sample_size = 0.0;
+
+    double halfWidth(double z = 1.96) const {
+        return z * standard_error;
+    }
+
+    std::pair<double, double> confidenceInterval(double z = 1.96) const {
+        return {mean - halfWidth(z), mean + halfWidth(z)};
+    }
+};
+
+// runTrials with the variance reduction of options.sampling. The trial must
+// take its generator as auto& and draw every random number from it, so the
+// wrappers above can shape the uniforms; it should use them monotonically
+// (as uniformBelow and uniformDouble do) for antithetic pairs to pay off.
+// Trials within a block are no longer independent, so the standard error
+// comes from the spread of block means, each block being an independent
+// replicate: with the default block size, at least a few dozen blocks are
+// needed for a stable error.
+template <typename Trial>
+Estimate estimate(uint64_t trials, const Trial& trial, const MonteCarloOptions& options = {}) {
+    const uint64_t num_blocks = (trials + options.block_size - 1) / options.block_size;
+    std::vector<TrialStats> block_stats(num_blocks);
+    TrialStats progress;
+
+    auto work = [&](Trial& local_trial, uint64_t b) {
+        Philox gen(options.seed, b);
+        const uint64_t begin = b * options.block_size;
+        const uint64_t end = std::min(trials, begin + options.block_size);
+        auto& stats = block_stats[b];
+        switch (options.sampling) {
+            case Sampling::Independent:
+                for (uint64_t t = begin; t < end; t++) {
+                    stats.add(local_trial(gen));
+                }
+                break;
+            case Sampling::Antithetic:
+                for (uint64_t t = begin; t < end; t += 2) {
+                    AntitheticGen<Philox> mirror {gen};
+                    stats.add(local_trial(gen));
+                    if (t + 1 < end) {
+                        stats.add(local_trial(mirror));
+                    }
+                }
+                break;
+            case Sampling::Stratified:
+                for (uint64_t t = begin; t < end; t++) {
+                    StratifiedGen<Philox> stratified {gen, t - begin, end - begin};
+                    stats.add(local_trial(stratified));
+                }
+                break;
+            case Sampling::Sobol: {
+                std::array<uint64_t, SobolGen<Philox>::DIMS> shift;
+                for (auto& word : shift) {
+                    word = gen();
+                }
+                for (uint64_t t = begin; t < end; t++) {
+                    SobolGen<Philox> sobol {gen, t - begin, shift};
+                    stats.add(local_trial(sobol));
+                }
+                break;
+            }
+        }
+    };
+    uint64_t kept = forEachBlock(num_blocks, options.num_threads, trial, work, [&](uint64_t b) {
+        if (options.target_half_width <= 0.0) {
+            return false;
+        }
+        progress.add(block_stats[b].mean);
+        return progress.count * options.block_size >= options.min_trials && progress.count > 1
+               && options.z * progress.standardError() <= options.target_half_width;
+    });
+
+    TrialStats pooled, replicates;
+    for (uint64_t b = 0; b < kept; b++) {
+        pooled.merge(block_stats[b]);
+        replicates.add(block_stats[b].mean);
+    }
+    Estimate res;
+    res.mean = pooled.mean;
+    res.trials = pooled.count;
+    res.trial_variance = pooled.variance();
+    res.standard_error = replicates.count > 1 ? replicates.standardError() : pooled.standardError();
+    res.effective_sample_size = res.standard_error > 0.0 ? res.trial_variance / (res.standard_error * res.standard_error)
+                                                         : static_cast<double>(res.trials);
+    return res;
+}
+
+// Runs trials LANES at a time: batch(gen, out) plays LANES independent
+// trials side by side, one per SIMD lane, and writes their outcomes to
+// out[0, LANES). Keeping every lane's state in arrays indexed by lane lets
+// the batch's loops vectorize, on top of the threads. Block b of trials
+// draws from a lane-parallel generator seeded from Philox stream b; lanes
+// past the last trial are dropped.
+template <size_t LANES, typename Batch>
+TrialStats runLaneTrials(uint64_t trials, const Batch& batch, const MonteCarloOptions& options = {}) {
+    const uint64_t block_size = (options.block_size + LANES - 1) / LANES * LANES;
+    const uint64_t num_blocks = (trials + block_size - 1) / block_size;
+    std::vector<TrialStats> block_stats(num_blocks);
+    forEachBlock(num_blocks, options.num_threads, batch, [&](Batch& local_batch, uint64_t b) {
+        alignas(64) std::array<double, LANES> out;
+        Philox philox(options.seed, b);
+        Xoshiro256x8 gen(philox());
+        uint64_t end = std::min(trials, (b + 1) * block_size);
+        for (uint64_t t = b * block_size; t < end; t += LANES) {
+            local_batch(gen, out);
+            for (size_t l = 0; l < LANES && t + l < end; l++) {
+                block_stats[b].add(out[l]);
+            }
+        }
+    }, [](uint64_t) { return false; });
+
+    TrialStats res;
+    for (const auto& s : block_stats) {
+        res.merge(s);
+    }
+    return res;
+}
\ No newline at end of file
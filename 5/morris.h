@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <vector>
+
+#include "rng.h"
+
+// Morris approximate counters (CLRS problem 5-1 with n_i = (base^i - 1) / (base - 1)).
+// A counter at value c stands for estimate(c) events and moves up with
+// probability base^-c, which keeps the estimate unbiased with variance
+// (base - 1) n (n - 1) / 2 after n events. An 8-bit counter with base 1.08
+// reaches about 4 * 10^9; base 1 + 2^-10 on 16 bits reaches 6 * 10^30.
+// Increments compare a raw 64-bit word with a precomputed threshold per
+// counter value, so no floating point is involved.
+template <typename Counter = uint8_t>
+struct MorrisCounters {
+    static_assert(std::is_unsigned_v<Counter> && sizeof(Counter) <= 2);
+    static constexpr size_t LEVELS = size_t{std::numeric_limits<Counter>::max()} + 1;
+
+    double base;
+    std::vector<Counter> counters;
+    // An increment happens when a random word is below thresholds[c]; the top level never moves.
+    std::array<uint64_t, LEVELS> thresholds;
+
+    MorrisCounters(size_t n, double base) : base {base}, counters(n) {
+        thresholds[0] = std::numeric_limits<uint64_t>::max();
+        for (size_t c = 1; c + 1 < LEVELS; c++) {
+            thresholds[c] = static_cast<uint64_t>(std::ldexp(std::pow(base, -static_cast<double>(c)), 64));
+        }
+        thresholds[LEVELS - 1] = 0;
+    }
+
+    double estimate(size_t i) const {
+        return (std::pow(base, counters[i]) - 1.0) / (base - 1.0);
+    }
+
+    double maxCount() const {
+        return (std::pow(base, static_cast<double>(LEVELS - 1)) - 1.0) / (base - 1.0);
+    }
+
+    // Standard deviation of the estimate after n events.
+    double standardDeviation(double n) const {
+        return std::sqrt((base - 1.0) * n * (n - 1.0) / 2.0);
+    }
+
+    // The estimate is within this factor of n with probability at least
+    // 1 - delta, by Chebyshev's inequality.
+    double relativeError(double delta) const {
+        return std::sqrt((base - 1.0) / (2.0 * delta));
+    }
+
+    template <typename Gen>
+    void increment(size_t i, Gen& gen) {
+        counters[i] += gen() < thresholds[counters[i]];
+    }
+
+    // Counts one event for each of indices[0, n). Random words come from the
+    // lane-parallel generator a block at a time; repeated indices are fine.
+    template <typename Index>
+    void increment(const Index* indices, size_t n, Xoshiro256x8& gen) {
+        constexpr size_t BLOCK = 512;
+        alignas(64) std::array<uint64_t, BLOCK> words;
+        for (size_t begin = 0; begin < n; begin += BLOCK) {
+            size_t count = std::min(BLOCK, n - begin);
+            gen.fill(words.data(), count);
+            for (size_t k = 0; k < count; k++) {
+                Counter& c = counters[indices[begin + k]];
+                c += words[k] < thresholds[c];
+            }
+        }
+    }
+
+    // Counts one event on every counter. With no indices to chase this is a
+    // branch-free pass over contiguous counters.
+    void incrementAll(Xoshiro256x8& gen) {
+        constexpr size_t BLOCK = 512;
+        alignas(64) std::array<uint64_t, BLOCK> words;
+        for (size_t begin = 0; begin < counters.size(); begin += BLOCK) {
+            size_t count = std::min(BLOCK, counters.size() - begin);
+            gen.fill(words.data(), count);
+            Counter* c = counters.data() + begin;
+            for (size_t k = 0; k < count; k++) {
+                c[k] += words[k] < thresholds[c[k]];
+            }
+        }
+    }
+
+    // Folds other's counters into these, which need the same base. Each
+    // level j below the smaller counter stands for base^j events; adding
+    // them one level at a time, moving up with probability base^(j - c),
+    // keeps the merged estimate unbiased.
+    template <typename Gen>
+    void merge(const MorrisCounters& other, Gen& gen) {
+        for (size_t i = 0; i < counters.size(); i++) {
+            Counter big = std::max(counters[i], other.counters[i]);
+            Counter small = std::min(counters[i], other.counters[i]);
+            for (Counter j = 0; j < small; j++) {
+                if (size_t{big} + 1 < LEVELS &&
+                    uniformDouble(gen) < std::pow(base, static_cast<double>(j) - static_cast<double>(big))) {
+                    big++;
+                }
+            }
+            counters[i] = big;
+        }
+    }
+};
\ No newline at end of file
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+struct PermutationStats {
+    uint64_t fixed_points = 0;
+    uint64_t records = 0; // left-to-right maxima, the hires of HIRE-ASSISTANT
+    uint64_t cycles = 0;
+    uint64_t inversions = 0;
+};
+
+// Computes all of PermutationStats in one pass over a permutation of
+// first, ..., first + n - 1. Inversions are counted with a Fenwick tree of
+// the values seen so far, and a cycle is walked and marked the first time
+// the pass reaches one of its elements, so the whole pass is O(n log n).
+// The tree and the marks are kept between calls; one instance per thread
+// makes it allocation-free inside a Monte Carlo trial.
+struct PermutationStatsKernel {
+    std::vector<uint32_t> tree;
+    std::vector<uint32_t> visited;
+    uint32_t epoch = 0;
+
+    template <typename T>
+    PermutationStats operator()(const T* p, size_t n, T first = T{}) {
+        tree.assign(n + 1, 0);
+        if (visited.size() < n || ++epoch == 0) {
+            visited.assign(std::max(visited.size(), n), 0);
+            epoch = 1;
+        }
+        PermutationStats res;
+        size_t best = 0;
+        for (size_t i = 0; i < n; i++) {
+            auto value = static_cast<size_t>(p[i] - first);
+            res.fixed_points += value == i;
+            if (i == 0 || value > best) {
+                res.records++;
+                best = value;
+            }
+            if (visited[i] != epoch) {
+                res.cycles++;
+                for (size_t j = i; visited[j] != epoch; j = static_cast<size_t>(p[j] - first)) {
+                    visited[j] = epoch;
+                }
+            }
+            uint64_t not_greater = 0;
+            for (size_t k = value + 1; k > 0; k &= k - 1) {
+                not_greater += tree[k];
+            }
+            res.inversions += i - not_greater;
+            for (size_t k = value + 1; k <= n; k += k & (~k + 1)) {
+                tree[k]++;
+            }
+        }
+        return res;
+    }
+
+    template <typename T>
+    PermutationStats operator()(const std::vector<T>& p, T first = T{}) {
+        return (*this)(p.data(), p.size(), first);
+    }
+};
\ No newline at end of file
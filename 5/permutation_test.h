@@ -0,0 +1,135 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <ostream>
+#include <thread>
+#include <vector>
+
+#include "rng.h"
+
+// Position of the permutation p of 0..n-1 in lexicographic order, from its
+// Lehmer code: digit i counts the unused values below p[i]. Needs n <= 20.
+inline uint64_t lehmerRank(const uint8_t* p, size_t n) {
+    uint32_t used = 0;
+    uint64_t rank = 0;
+    for (size_t i = 0; i < n; i++) {
+        uint32_t below = (uint32_t{1} << p[i]) - 1;
+        rank = rank * (n - i) + static_cast<uint64_t>(p[i] - std::popcount(used & below));
+        used |= uint32_t{1} << p[i];
+    }
+    return rank;
+}
+
+// Standard normal score of a chi-square statistic, by the Wilson-Hilferty
+// cube-root approximation. Large positive values mean a poor fit.
+inline double chiSquareZ(double chi2, double df) {
+    double c = 2.0 / (9.0 * df);
+    return (std::cbrt(chi2 / df) - (1.0 - c)) / std::sqrt(c);
+}
+
+struct PermutationTestResult {
+    uint64_t samples = 0;
+    double seconds = 0.0;
+    // Over all n! orders; left at 0 when n! is too large to histogram.
+    double rank_chi2 = 0.0;
+    double rank_z = 0.0;
+    // Over the n x n table of where each value lands.
+    double position_chi2 = 0.0;
+    double position_z = 0.0;
+
+    bool passed(double max_z = 5.0) const {
+        return rank_z < max_z && position_z < max_z;
+    }
+};
+
+inline std::ostream& operator<<(std::ostream& os, const PermutationTestResult& res) {
+    os << res.samples << " permutations in " << res.seconds << "s, rank chi-square " << res.rank_chi2 << " (z "
+       << res.rank_z << "), position chi-square " << res.position_chi2 << " (z " << res.position_z << ") : "
+       << (res.passed() ? "uniform" : "NOT uniform");
+    return os;
+}
+
+// Runs shuffle(p, n, gen) on the identity permutation of 0..n-1 the given
+// number of times and tests the results for uniformity: a chi-square over
+// the Lehmer ranks when n <= 10, and over the position of every value. Work
+// is split in blocks, block b drawing from Philox stream b of the seed, and
+// each thread keeps its own histograms, so millions of permutations take
+// well under a second per core.
+template <typename Shuffle>
+PermutationTestResult testPermutations(size_t n, uint64_t samples, Shuffle shuffle, uint64_t seed,
+                                       size_t num_threads = std::thread::hardware_concurrency()) {
+    constexpr uint64_t BLOCK = 1 << 14;
+    const uint64_t num_blocks = (samples + BLOCK - 1) / BLOCK;
+    num_threads = std::clamp<uint64_t>(num_threads, 1, std::max<uint64_t>(num_blocks, 1));
+    uint64_t orders = 1;
+    for (size_t i = 2; i <= n && n <= 10; i++) {
+        orders *= i;
+    }
+    const bool by_rank = n <= 10;
+    std::vector<std::vector<uint64_t>> rank_count(num_threads, std::vector<uint64_t>(by_rank ? orders : 0));
+    std::vector<std::vector<uint64_t>> position_count(num_threads, std::vector<uint64_t>(n * n));
+    std::atomic<uint64_t> next_block {0};
+
+    auto worker = [&](size_t t) {
+        std::vector<uint8_t> p(n);
+        auto& ranks = rank_count[t];
+        auto& positions = position_count[t];
+        for (uint64_t b = next_block++; b < num_blocks; b = next_block++) {
+            Philox philox(seed, b);
+            Xoshiro256pp gen(philox());
+            for (uint64_t s = b * BLOCK; s < std::min(samples, (b + 1) * BLOCK); s++) {
+                std::iota(p.begin(), p.end(), 0);
+                shuffle(p.data(), n, gen);
+                if (by_rank) {
+                    ranks[lehmerRank(p.data(), n)]++;
+                }
+                for (size_t i = 0; i < n; i++) {
+                    positions[i * n + p[i]]++;
+                }
+            }
+        }
+    };
+    auto t1 = std::chrono::steady_clock::now();
+    std::vector<std::thread> workers;
+    for (size_t t = 1; t < num_threads; t++) {
+        workers.emplace_back(worker, t);
+    }
+    worker(0);
+    for (auto& w : workers) {
+        w.join();
+    }
+    auto t2 = std::chrono::steady_clock::now();
+
+    PermutationTestResult res;
+    res.samples = samples;
+    res.seconds = std::chrono::duration<double>(t2 - t1).count();
+    auto chiSquare = [num_threads](const std::vector<std::vector<uint64_t>>& counts, size_t bins, double expected) {
+        double chi2 = 0.0;
+        for (size_t i = 0; i < bins; i++) {
+            uint64_t observed = 0;
+            for (size_t t = 0; t < num_threads; t++) {
+                observed += counts[t][i];
+            }
+            double diff = static_cast<double>(observed) - expected;
+            chi2 += diff * diff / expected;
+        }
+        return chi2;
+    };
+    const auto total = static_cast<double>(samples);
+    if (by_rank && orders > 1) {
+        res.rank_chi2 = chiSquare(rank_count, orders, total / static_cast<double>(orders));
+        res.rank_z = chiSquareZ(res.rank_chi2, static_cast<double>(orders - 1));
+    }
+    if (n > 1) {
+        // Rows and columns of the table both sum to samples: (n - 1)^2 degrees of freedom.
+        res.position_chi2 = chiSquare(position_count, n * n, total / static_cast<double>(n));
+        res.position_z = chiSquareZ(res.position_chi2, static_cast<double>((n - 1) * (n - 1)));
+    }
+    return res;
+}
\ No newline at end of file
@@ -0,0 +1,262 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3").
+// Block i of stream s is a keyed bijection of the counter (i, s), so any
+// stream can be started anywhere without generating what comes before it,
+// and streams with different indices never overlap.
+struct Philox {
+    using result_type = uint64_t;
+
+    std::array<uint32_t, 2> key;
+    uint64_t stream;
+    uint64_t position = 0;
+    std::array<uint64_t, 2> buffer {};
+    size_t index = 2;
+
+    Philox(uint64_t seed, uint64_t stream = 0)
+            : key {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32u)}, stream {stream} {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    static std::array<uint32_t, 4> block(std::array<uint32_t, 4> ctr, std::array<uint32_t, 2> k) {
+        for (size_t round = 0; round < 10; round++) {
+            uint64_t p0 = static_cast<uint64_t>(0xD2511F53u) * ctr[0];
+            uint64_t p1 = static_cast<uint64_t>(0xCD9E8D57u) * ctr[2];
+            ctr = {static_cast<uint32_t>(p1 >> 32u) ^ ctr[1] ^ k[0], static_cast<uint32_t>(p1),
+                   static_cast<uint32_t>(p0 >> 32u) ^ ctr[3] ^ k[1], static_cast<uint32_t>(p0)};
+            k[0] += 0x9E3779B9u;
+            k[1] += 0xBB67AE85u;
+        }
+        return ctr;
+    }
+
+    result_type operator()() {
+        if (index == 2) {
+            auto out = block({static_cast<uint32_t>(position), static_cast<uint32_t>(position >> 32u),
+                              static_cast<uint32_t>(stream), static_cast<uint32_t>(stream >> 32u)}, key);
+            buffer = {out[0] | static_cast<uint64_t>(out[1]) << 32u, out[2] | static_cast<uint64_t>(out[3]) << 32u};
+            position++;
+            index = 0;
+        }
+        return buffer[index++];
+    }
+
+    void discard(uint64_t n) {
+        for (; n && index < 2; n--) {
+            index++;
+        }
+        position += n / 2;
+        if (n % 2) {
+            (*this)();
+        }
+    }
+};
+
+inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+inline uint64_t splitMix64(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15u);
+    z = (z ^ (z >> 30u)) * 0xBF58476D1CE4E5B9u;
+    z = (z ^ (z >> 27u)) * 0x94D049BB133111EBu;
+    return z ^ (z >> 31u);
+}
+
+// xoshiro256++ (Blackman and Vigna), seeded through SplitMix64.
+struct Xoshiro256pp {
+    using result_type = uint64_t;
+
+    std::array<uint64_t, 4> s;
+
+    explicit Xoshiro256pp(uint64_t seed = 0) {
+        for (auto& word : s) {
+            word = splitMix64(seed);
+        }
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        uint64_t res = rotl(s[0] + s[3], 23) + s[0];
+        uint64_t t = s[1] << 17u;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = rotl(s[3], 45);
+        return res;
+    }
+
+    // Advances by 2^128 outputs, giving non-overlapping subsequences for parallel use.
+    void jump() {
+        constexpr std::array<uint64_t, 4> JUMP {0x180EC6D33CFD0ABAu, 0xD5A61266F0C9392Cu,
+                                                0xA9582618E03FC9AAu, 0x39ABDC4529B1661Cu};
+        std::array<uint64_t, 4> t {};
+        for (auto word : JUMP) {
+            for (size_t b = 0; b < 64; b++) {
+                if (word & (uint64_t{1} << b)) {
+                    for (size_t i = 0; i < 4; i++) {
+                        t[i] ^= s[i];
+                    }
+                }
+                (*this)();
+            }
+        }
+        s = t;
+    }
+};
+
+// Eight xoshiro256++ generators, 2^128 apart, stepped in lockstep. The state
+// is laid out lane by lane so the update loops compile to vector code.
+struct Xoshiro256x8 {
+    static constexpr size_t LANES = 8;
+
+    alignas(32) std::array<uint64_t, LANES> s0, s1, s2, s3;
+
+    explicit Xoshiro256x8(uint64_t seed = 0) {
+        Xoshiro256pp gen(seed);
+        for (size_t l = 0; l < LANES; l++) {
+            s0[l] = gen.s[0];
+            s1[l] = gen.s[1];
+            s2[l] = gen.s[2];
+            s3[l] = gen.s[3];
+            gen.jump();
+        }
+    }
+
+    void fill(uint64_t* out, size_t n) {
+        // Work on local copies so the stores to out cannot alias the state.
+        alignas(32) std::array<uint64_t, LANES> a = s0, b = s1, c = s2, d = s3;
+        alignas(32) std::array<uint64_t, LANES> res;
+        for (size_t i = 0; i < n; i += LANES) {
+            for (size_t l = 0; l < LANES; l++) {
+                res[l] = rotl(a[l] + d[l], 23) + a[l];
+                uint64_t t = b[l] << 17u;
+                c[l] ^= a[l];
+                d[l] ^= b[l];
+                b[l] ^= c[l];
+                a[l] ^= d[l];
+                c[l] ^= t;
+                d[l] = rotl(d[l], 45);
+            }
+            if (i + LANES <= n) {
+                for (size_t l = 0; l < LANES; l++) {
+                    out[i + l] = res[l];
+                }
+            } else {
+                std::copy(res.begin(), res.begin() + (n - i), out + i);
+            }
+        }
+        s0 = a;
+        s1 = b;
+        s2 = c;
+        s3 = d;
+    }
+};
+
+// Uniform integer in [0, range) with Lemire's nearly divisionless method:
+// the high half of gen() * range, with a division only on the rare
+// rejection path. Gen must produce full 64-bit words.
+template <typename Gen>
+uint64_t uniformBelow(Gen& gen, uint64_t range) {
+    static_assert(Gen::min() == 0 && Gen::max() == std::numeric_limits<uint64_t>::max());
+    assert(range > 0);
+    unsigned __int128 m = static_cast<unsigned __int128>(gen()) * range;
+    auto low = static_cast<uint64_t>(m);
+    if (low < range) {
+        uint64_t threshold = -range % range;
+        while (low < threshold) {
+            m = static_cast<unsigned __int128>(gen()) * range;
+            low = static_cast<uint64_t>(m);
+        }
+    }
+    return static_cast<uint64_t>(m >> 64u);
+}
+
+// Uniform integer in [a, b]. The span is taken in unsigned arithmetic, so
+// any a <= b works, the full int64_t range included.
+template <typename Gen>
+int64_t uniformInt(Gen& gen, int64_t a, int64_t b) {
+    assert(a <= b);
+    uint64_t span = static_cast<uint64_t>(b) - static_cast<uint64_t>(a);
+    uint64_t offset = span == std::numeric_limits<uint64_t>::max() ? gen() : uniformBelow(gen, span + 1);
+    return static_cast<int64_t>(static_cast<uint64_t>(a) + offset);
+}
+
+// Uniform double in [0, 1) from the top 53 bits of one word.
+template <typename Gen>
+double uniformDouble(Gen& gen) {
+    return static_cast<double>(gen() >> 11u) * 0x1.0p-53;
+}
+
+// Fills out[0, n) with uniform integers in [0, range). Raw words come from
+// the lane-parallel generator a cache-sized block at a time and are mapped
+// in place; the rare rejected word is redrawn on its own.
+inline void fillBelow(Xoshiro256x8& gen, uint64_t* out, size_t n, uint64_t range) {
+    constexpr size_t BLOCK = 512;
+    assert(range > 0);
+    const uint64_t threshold = -range % range;
+    for (size_t begin = 0; begin < n; begin += BLOCK) {
+        size_t end = std::min(n, begin + BLOCK);
+        gen.fill(out + begin, end - begin);
+        for (size_t i = begin; i < end; i++) {
+            unsigned __int128 m = static_cast<unsigned __int128>(out[i]) * range;
+            while (static_cast<uint64_t>(m) < threshold) [[unlikely]] {
+                uint64_t word;
+                gen.fill(&word, 1);
+                m = static_cast<unsigned __int128>(word) * range;
+            }
+            out[i] = static_cast<uint64_t>(m >> 64u);
+        }
+    }
+}
+
+// Fills out[0, n) with uniform integers in [0, range) two per random word,
+// by Lemire's method on 32-bit halves. The main loop has no branches, so
+// the products vectorize; the rare rejected value is redrawn afterwards.
+inline void fillBelow32(Xoshiro256x8& gen, uint32_t* out, size_t n, uint32_t range) {
+    constexpr size_t BLOCK = 256;
+    assert(range > 0);
+    const uint32_t threshold = -range % range;
+    alignas(64) std::array<uint64_t, BLOCK> words;
+    alignas(64) std::array<uint32_t, 2 * BLOCK> values, low;
+    for (size_t begin = 0; begin < n; begin += 2 * BLOCK) {
+        size_t count = std::min(n - begin, 2 * BLOCK);
+        gen.fill(words.data(), BLOCK);
+        for (size_t i = 0; i < BLOCK; i++) {
+            uint64_t m0 = static_cast<uint64_t>(static_cast<uint32_t>(words[i])) * range;
+            uint64_t m1 = static_cast<uint64_t>(static_cast<uint32_t>(words[i] >> 32u)) * range;
+            values[i] = static_cast<uint32_t>(m0 >> 32u);
+            values[BLOCK + i] = static_cast<uint32_t>(m1 >> 32u);
+            low[i] = static_cast<uint32_t>(m0);
+            low[BLOCK + i] = static_cast<uint32_t>(m1);
+        }
+        uint32_t rejected = 0;
+        for (auto l : low) {
+            rejected |= static_cast<uint32_t>(l < threshold);
+        }
+        if (rejected) [[unlikely]] {
+            for (size_t i = 0; i < count; i++) {
+                while (low[i] < threshold) {
+                    uint64_t word;
+                    gen.fill(&word, 1);
+                    uint64_t m = (word & 0xFFFFFFFFu) * range;
+                    values[i] = static_cast<uint32_t>(m >> 32u);
+                    low[i] = static_cast<uint32_t>(m);
+                }
+            }
+        }
+        std::copy(values.begin(), values.begin() + count, out + begin);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "rng.h"
+
+// RANDOMIZE-IN-PLACE on a raw range.
+template <typename T, typename Gen>
+void fisherYates(T* data, size_t n, Gen& gen) {
+    for (size_t i = 0; i + 1 < n; i++) {
+        std::swap(data[i], data[i + uniformBelow(gen, n - i)]);
+    }
+}
+
+// Scatters every element into one of B buckets chosen uniformly at random,
+// then shuffles each bucket on its own (Sanders, "Random permutations on
+// distributed, external and hierarchical memory"). The result is a uniform
+// permutation; memory is touched in B sequential streams instead of at
+// random, and buckets are recursed into until they fit in cache. The result
+// ends up in data, scratch must hold n elements.
+template <typename T, typename Gen>
+void scatterShuffle(T* data, T* scratch, size_t n, Gen& gen, size_t leaf_size) {
+    if (n <= leaf_size) {
+        fisherYates(data, n, gen);
+        return;
+    }
+    constexpr size_t B = 256;
+    std::vector<uint8_t> ids(n);
+    std::array<size_t, B + 1> offsets {};
+    for (size_t i = 0; i < n; i++) {
+        ids[i] = static_cast<uint8_t>(uniformBelow(gen, B));
+        offsets[ids[i] + 1]++;
+    }
+    for (size_t b = 0; b < B; b++) {
+        offsets[b + 1] += offsets[b];
+    }
+    auto next = offsets;
+    for (size_t i = 0; i < n; i++) {
+        scratch[next[ids[i]]++] = std::move(data[i]);
+    }
+    for (size_t b = 0; b < B; b++) {
+        scatterShuffle(scratch + offsets[b], data + offsets[b], offsets[b + 1] - offsets[b], gen, leaf_size);
+    }
+    std::move(scratch, scratch + n, data);
+}
+
+// Parallel version of the above for the top level: every thread scatters
+// its own chunk into the shared buckets at precomputed offsets, then the
+// buckets are shuffled independently by whichever thread is free. Chunk t
+// and bucket b draw from Philox streams of the seed, so the permutation is
+// reproducible from the seed and thread count.
+template <typename T>
+void parallelShuffle(std::vector<T>& v, uint64_t seed, size_t num_threads = std::thread::hardware_concurrency(),
+                     size_t leaf_size = size_t{1} << 15u) {
+    const size_t n = v.size();
+    leaf_size = std::max<size_t>(leaf_size, 1);
+    auto stream = [seed](uint64_t s) {
+        Philox philox(seed, s);
+        return Xoshiro256pp(philox());
+    };
+    if (n <= leaf_size) {
+        auto gen = stream(0);
+        fisherYates(v.data(), n, gen);
+        return;
+    }
+    const size_t B = std::clamp<size_t>(n / leaf_size, 2, 1024);
+    num_threads = std::clamp<size_t>(num_threads, 1, n / leaf_size);
+    std::vector<uint16_t> ids(n);
+    std::vector<std::vector<size_t>> offsets(num_threads, std::vector<size_t>(B));
+
+    auto run = [num_threads](auto f) {
+        std::vector<std::thread> workers;
+        for (size_t t = 1; t < num_threads; t++) {
+            workers.emplace_back(f, t);
+        }
+        f(0);
+        for (auto& w : workers) {
+            w.join();
+        }
+    };
+    auto chunk = [n, num_threads](size_t t) {
+        return std::pair<size_t, size_t> {n * t / num_threads, n * (t + 1) / num_threads};
+    };
+
+    run([&](size_t t) {
+        auto gen = stream(t);
+        auto [low, high] = chunk(t);
+        for (size_t i = low; i < high; i++) {
+            ids[i] = static_cast<uint16_t>(uniformBelow(gen, B));
+            offsets[t][ids[i]]++;
+        }
+    });
+    std::vector<size_t> bucket_begin(B + 1);
+    size_t total = 0;
+    for (size_t b = 0; b < B; b++) {
+        bucket_begin[b] = total;
+        for (size_t t = 0; t < num_threads; t++) {
+            size_t count = offsets[t][b];
+            offsets[t][b] = total;
+            total += count;
+        }
+    }
+    bucket_begin[B] = n;
+
+    std::vector<T> tmp(n);
+    run([&](size_t t) {
+        auto [low, high] = chunk(t);
+        auto& next = offsets[t];
+        for (size_t i = low; i < high; i++) {
+            tmp[next[ids[i]]++] = std::move(v[i]);
+        }
+    });
+
+    std::atomic<size_t> next_bucket {0};
+    run([&](size_t) {
+        for (size_t b = next_bucket++; b < B; b = next_bucket++) {
+            auto gen = stream(num_threads + b);
+            size_t begin = bucket_begin[b];
+            scatterShuffle(tmp.data() + begin, v.data() + begin, bucket_begin[b + 1] - begin, gen, leaf_size);
+        }
+    });
+    v.swap(tmp);
+}
\ No newline at end of file
@@ -3,7 +3,9 @@
 #include <random>
 #include <vector>
 
-std::mt19937 gen(std::random_device{}());
+#include "../5/rng.h"
+
+Xoshiro256pp gen(std::random_device{}());
 
 template <typename T>
 size_t partition(std::vector<T>& A, size_t p, size_t r) {
@@ -21,8 +23,7 @@ size_t partition(std::vector<T>& A, size_t p, size_t r) {
 
 template <typename T>
 size_t randomizedPartition(std::vector<T>& A, size_t p, size_t r) {
-    std::uniform_int_distribution<> dst (p, r);
-    size_t i = dst(gen);
+    size_t i = uniformInt(gen, p, r);
     std::swap(A[i], A[r]);
     return partition(A, p, r);
 }